@@ -0,0 +1,332 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Bar.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the bar graphs and level meters, which fill cells a pixel column or row at a time using glyphs shared through a glyph cache
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// the number of pixel columns of a cell
+#define   CELL_WIDTH			5
+// the number of pixel rows of a cell
+#define   CELL_HEIGHT			8
+// the row of a cell whose pixels are all set
+#define   ROW_FULL				0x1F
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Returns the character a cell of a bar shows at a level
+ *
+ * @param		bar					Pointer to the bar
+ * @param		cell				Index of the cell within the bar
+ * @param		level				Number of pixel columns that are filled
+ *
+ * @return							Code of the character
+ */
+static uint8_t LCD_barCode(const HD44780_LCD_Bar_t *bar, uint32_t cell, uint32_t level) {
+	const uint32_t start = cell * CELL_WIDTH;
+
+	if (level <= start) {
+		return ' ';
+	}
+	if (level >= start + CELL_WIDTH) {
+		return LCD_ROM_FULL_BLOCK;
+	}
+
+	return bar->locs[level - start - 1];
+}
+
+/**
+ * @brief							Rewrites the cells of a bar within a range whose characters differ from the DDRAM
+ *
+ * @param		bar					Pointer to the bar
+ * @param		first				Index of the first cell
+ * @param		last				Index of the last cell
+ *
+ * @return							Status of the transfers to the LCD (the update stops at the first transfer that fails)
+ */
+static HAL_StatusTypeDef LCD_drawBarCells(const HD44780_LCD_Bar_t *bar, uint32_t first, uint32_t last) {
+	HD44780_LCD_t *lcd = bar->cache->lcd;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint32_t cell = first; cell <= last && status == HAL_OK; ++cell) {
+		const uint32_t col = bar->col + cell;
+		const uint8_t addr = ((bar->row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+		const uint8_t code = LCD_barCode(bar, cell, bar->level);
+
+		if (LCD_SHADOW_DDRAM_IS(lcd, bar->row, col, code)) {
+			continue;
+		}
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, bar->row, col);
+		}
+		status = LCD_sendData(lcd, code);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Returns the character a cell of a meter shows
+ *
+ * @param		meter				Pointer to the meter
+ * @param		cell				Index of the cell (cells are numbered row by row, the top row first)
+ *
+ * @return							Code of the character
+ */
+static uint8_t LCD_meterCode(const HD44780_LCD_Meter_t *meter, uint32_t cell) {
+	const uint32_t bar = cell % meter->bars;
+	const uint32_t below = (meter->rows - 1 - cell / meter->bars) * CELL_HEIGHT;
+	const uint32_t level = meter->shown[bar];
+
+	if (level <= below) {
+		return ' ';
+	}
+	if (level >= below + CELL_HEIGHT) {
+		return LCD_ROM_FULL_BLOCK;
+	}
+
+	return meter->locs[level - below - 1];
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes an empty bar over a segment of a row, acquiring the glyphs of its partly filled cells from a glyph cache
+ *
+ * Each cell is filled from the left a pixel column at a time, so a bar of width cells has 5 * width levels. Partly filled cells show one of 4
+ * glyphs (1 to 4 columns set) and full cells show LCD_ROM_FULL_BLOCK from the ROM, so every bar acquiring from the same cache shares the same
+ * 4 locations of the CGRAM, which are loaded only by the first of them
+ *
+ * @param		bar					Pointer to the bar
+ * @param		cache				Pointer to the glyph cache, which must have 4 free locations unless another bar already holds the glyphs
+ * @param		row					Row of the bar (0 or 1)
+ * @param		col					Column of the first cell of the bar
+ * @param		width				Number of cells of the bar
+ *
+ * @return							Status of the transfers to the LCD, HAL_BUSY if the glyphs do not fit in the cache (no glyph is then held)
+ */
+HAL_StatusTypeDef LCD_initBar(HD44780_LCD_Bar_t *bar, HD44780_LCD_GlyphCache_t *cache, uint8_t row, uint8_t col, uint8_t width) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	bar->cache = cache;
+	bar->row = row;
+	bar->col = col;
+	bar->width = width;
+	bar->level = 0;
+
+	// the glyph of index i has the i + 1 left-most columns set on every row
+	for (uint32_t i = 0; i < CELL_WIDTH - 1 && status == HAL_OK; ++i) {
+		const uint8_t bits = (ROW_FULL << (CELL_WIDTH - 1 - i)) & ROW_FULL;
+		const uint8_t glyph[8] = { bits, bits, bits, bits, bits, bits, bits, bits };
+
+		status = LCD_acquireGlyph(cache, glyph, &(bar->locs[i]));
+
+		if (status == HAL_BUSY) {
+			while (i-- > 0) {
+				LCD_releaseGlyph(cache, bar->locs[i]);
+			}
+			return status;
+		}
+	}
+
+	if (status == HAL_OK && width != 0) {
+		status = LCD_drawBarCells(bar, 0, width - 1);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sets the level of a bar, rewriting only the cells between the old and the new level (usually a single cell)
+ *
+ * @param		bar					Pointer to the bar
+ * @param		level				Number of pixel columns that are filled (clamped to 5 * width)
+ *
+ * @return							Status of the transfers to the LCD
+ */
+HAL_StatusTypeDef LCD_setBar(HD44780_LCD_Bar_t *bar, uint16_t level) {
+	const uint32_t max = bar->width * CELL_WIDTH;
+	uint32_t lo = bar->level;
+	uint32_t hi;
+
+	if (level > max) {
+		level = max;
+	}
+	if (level == bar->level) {
+		return HAL_OK;
+	}
+
+	hi = level;
+	if (lo > hi) {
+		hi = lo;
+		lo = level;
+	}
+	bar->level = level;
+
+	// the cells from the one holding the lower level to the one holding the higher level are the only ones that can change
+	return LCD_drawBarCells(bar, lo / CELL_WIDTH, (hi - 1) / CELL_WIDTH);
+}
+
+/**
+ * @brief							Releases the glyphs of a bar back to its glyph cache (the cells of the bar should be overwritten first)
+ *
+ * @param		bar					Pointer to the bar
+ */
+void LCD_releaseBar(HD44780_LCD_Bar_t *bar) {
+	for (uint32_t i = 0; i < CELL_WIDTH - 1; ++i) {
+		LCD_releaseGlyph(bar->cache, bar->locs[i]);
+	}
+}
+
+/**
+ * @brief							Initializes an empty level meter of vertical bars, acquiring the glyphs of its partly filled cells from a glyph cache
+ *
+ * Each bar is a column of 1 or 2 cells filled from the bottom a pixel row at a time, so it has 8 levels per cell. Partly filled cells show one of
+ * 7 glyphs (1 to 7 bottom rows set) and full cells show LCD_ROM_FULL_BLOCK from the ROM. LCD_setMeter only stores the levels of a frame, and
+ * LCD_flushMeter sends the cells that changed, so the loop producing the levels decides how much time it spends on the LCD
+ *
+ * @param		meter				Pointer to the meter
+ * @param		cache				Pointer to the glyph cache, which must have 7 free locations unless another meter already holds the glyphs
+ * @param		row					Row of the top cells of the bars (0 or 1, and 0 for bars of 2 cells)
+ * @param		col					Column of the first bar
+ * @param		bars				Number of bars (1 to LCD_METER_MAX_BARS)
+ * @param		rows				Number of cells of each bar (1 or 2)
+ * @param		decay				Number of frames after which a bar that is above its level falls by one pixel row (0 to always show the level)
+ *
+ * @return							Status of the transfers to the LCD, HAL_ERROR if the meter does not fit, HAL_BUSY if the glyphs do not fit in the cache
+ */
+HAL_StatusTypeDef LCD_initMeter(HD44780_LCD_Meter_t *meter, HD44780_LCD_GlyphCache_t *cache, uint8_t row, uint8_t col, uint8_t bars,
+		uint8_t rows, uint8_t decay) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	if (bars == 0 || bars > LCD_METER_MAX_BARS || rows == 0 || row + rows > 2) {
+		return HAL_ERROR;
+	}
+
+	meter->cache = cache;
+	meter->row = row;
+	meter->col = col;
+	meter->bars = bars;
+	meter->rows = rows;
+	meter->decay = decay;
+	meter->next = 0;
+
+	for (uint32_t bar = 0; bar < LCD_METER_MAX_BARS; ++bar) {
+		meter->shown[bar] = 0;
+		meter->hold[bar] = 0;
+	}
+
+	// the glyph of index i has the i + 1 bottom rows set
+	for (uint32_t i = 0; i < CELL_HEIGHT - 1 && status == HAL_OK; ++i) {
+		uint8_t glyph[CELL_HEIGHT];
+
+		for (uint32_t r = 0; r < CELL_HEIGHT; ++r) {
+			glyph[r] = (r >= CELL_HEIGHT - 1 - i) ? (ROW_FULL) : (0);
+		}
+
+		status = LCD_acquireGlyph(cache, glyph, &(meter->locs[i]));
+
+		if (status == HAL_BUSY) {
+			while (i-- > 0) {
+				LCD_releaseGlyph(cache, meter->locs[i]);
+			}
+			return status;
+		}
+	}
+
+	if (status == HAL_OK) {
+		LCD_flushMeter(meter, bars * rows);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Stores the levels of the next frame of a meter, without sending anything to the LCD
+ *
+ * A bar whose level rises shows it at once. With a decay, a bar whose level falls holds the highest level it showed and falls from it by one pixel
+ * row every decay frames, until it meets the level again
+ *
+ * @param		meter				Pointer to the meter
+ * @param		levels				Level of each bar, in pixel rows (clamped to 8 * rows)
+ */
+void LCD_setMeter(HD44780_LCD_Meter_t *meter, const uint8_t *levels) {
+	const uint32_t max = meter->rows * CELL_HEIGHT;
+
+	for (uint32_t bar = 0; bar < meter->bars; ++bar) {
+		const uint8_t level = (levels[bar] > max) ? (max) : (levels[bar]);
+
+		if (level >= meter->shown[bar] || meter->decay == 0) {
+			meter->shown[bar] = level;
+			meter->hold[bar] = meter->decay;
+		} else if (--meter->hold[bar] == 0) {
+			--meter->shown[bar];
+			meter->hold[bar] = meter->decay;
+		}
+	}
+}
+
+/**
+ * @brief							Sends up to a number of the cells of a meter that differ from the DDRAM, and can be called as often as the loop allows
+ *
+ * Each call resumes from the cell after the last one it sent, so bars are not starved when frames come faster than they are flushed
+ *
+ * @param		meter				Pointer to the meter
+ * @param		max					Most cells to send
+ *
+ * @return							Number of cells that were sent (0 once the LCD shows the last frame)
+ */
+uint32_t LCD_flushMeter(HD44780_LCD_Meter_t *meter, uint32_t max) {
+	HD44780_LCD_t *lcd = meter->cache->lcd;
+	const uint32_t cells = meter->bars * meter->rows;
+	uint32_t cell = meter->next;
+	uint32_t sent = 0;
+
+	if (cell >= cells) {
+		cell = 0;
+	}
+
+	for (uint32_t i = 0; i < cells && sent < max; ++i) {
+		const uint32_t row = meter->row + cell / meter->bars;
+		const uint32_t col = meter->col + cell % meter->bars;
+		const uint8_t addr = ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+		const uint8_t code = LCD_meterCode(meter, cell);
+
+		if (++cell == cells) {
+			cell = 0;
+		}
+		if (LCD_SHADOW_DDRAM_IS(lcd, row, col, code)) {
+			continue;
+		}
+
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, row, col);
+		}
+		if (LCD_sendData(lcd, code) != HAL_OK) {
+			break;
+		}
+
+		++sent;
+		meter->next = cell;
+	}
+
+	return sent;
+}
+
+/**
+ * @brief							Releases the glyphs of a meter back to its glyph cache (the cells of the meter should be overwritten first)
+ *
+ * @param		meter				Pointer to the meter
+ */
+void LCD_releaseMeter(HD44780_LCD_Meter_t *meter) {
+	for (uint32_t i = 0; i < CELL_HEIGHT - 1; ++i) {
+		LCD_releaseGlyph(meter->cache, meter->locs[i]);
+	}
+}
@@ -0,0 +1,207 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_BigDigits.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the big digits, which draw numerals two rows high from a small set of segment glyphs of the CGRAM
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// codes of the cells of the built-in font: upper bar, lower bar, both bars, dot of a colon, decimal point, full block and space (codes below
+// LCD_CGRAM_GLYPHS are glyphs of the font, numbered from its first location, and the rest are characters of the ROM)
+#define   UB					0
+#define   LB					1
+#define   BB					2
+#define   CD					3
+#define   DP					4
+#define   FB					LCD_ROM_FULL_BLOCK
+#define   SP					' '
+
+/** Big Fonts ----------------------------------------------------------------*/
+
+// glyphs of the built-in font, in the order of their codes
+static const uint8_t LCD_BIG_GLYPHS_3X2[][8] = {
+	{ 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F },
+	{ 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x1F, 0x1F, 0x1F },
+	{ 0x00, 0x00, 0x00, 0x0E, 0x0E, 0x0E, 0x00, 0x00 },
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0E, 0x0E, 0x0E }
+};
+
+// cells of the digits 0 to 9, the top row followed by the bottom row
+static const uint8_t LCD_BIG_DIGITS_3X2[10][6] = {
+	{ FB, UB, FB,	FB, LB, FB },
+	{ UB, FB, SP,	LB, FB, LB },
+	{ BB, BB, FB,	FB, LB, LB },
+	{ BB, BB, FB,	LB, LB, FB },
+	{ FB, LB, FB,	SP, SP, FB },
+	{ FB, BB, BB,	LB, LB, FB },
+	{ FB, BB, BB,	FB, LB, FB },
+	{ UB, UB, FB,	SP, SP, FB },
+	{ FB, BB, FB,	FB, LB, FB },
+	{ FB, BB, FB,	LB, LB, FB }
+};
+
+const HD44780_LCD_BigFont_t LCD_BIG_FONT_3X2 = {
+	.glyphs = LCD_BIG_GLYPHS_3X2,
+	.digits = &LCD_BIG_DIGITS_3X2[0][0],
+	.colon = { CD, CD },
+	.dot = { SP, DP },
+	.count = sizeof(LCD_BIG_GLYPHS_3X2) / sizeof(LCD_BIG_GLYPHS_3X2[0]),
+	.width = 3,
+	.spacing = 1
+};
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Writes a cell of big digits if it differs from the DDRAM
+ *
+ * @param		big					Pointer to the big digits
+ * @param		row					Row of the cell (0 or 1)
+ * @param		col					Column of the cell (cells beyond the line are ignored)
+ * @param		code				Code of the cell in the font (a glyph of the font, or a character of the ROM)
+ *
+ * @return							Status of the transfers to the LCD
+ */
+static HAL_StatusTypeDef LCD_drawBigCell(HD44780_LCD_BigDigits_t *big, uint32_t row, uint32_t col, uint8_t code) {
+	HD44780_LCD_t *lcd = big->lcd;
+	const uint8_t addr = ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+
+	if (code < LCD_CGRAM_GLYPHS) {
+		code += big->firstLoc;
+	}
+	if (col >= LCD_LINE_SIZE || LCD_SHADOW_DDRAM_IS(lcd, row, col, code)) {
+		return HAL_OK;
+	}
+
+	if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+		LCD_setCursorPos(lcd, row, col);
+	}
+	return LCD_sendData(lcd, code);
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Loads the glyphs of a big font into consecutive locations of the CGRAM with a single address instruction, unless they are already there
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		font				Pointer to the font
+ * @param		firstLoc			Location of the first glyph of the font
+ *
+ * @return							Status of the transfers to the LCD, HAL_ERROR if the glyphs do not fit in the CGRAM
+ */
+HAL_StatusTypeDef LCD_loadBigFont(HD44780_LCD_t *lcd, const HD44780_LCD_BigFont_t *font, uint8_t firstLoc) {
+	const uint8_t *rows = &(font->glyphs[0][0]);
+	const uint32_t len = font->count * 8;
+	uint32_t i = 0;
+	HAL_StatusTypeDef status;
+
+	if (firstLoc + font->count > LCD_CGRAM_GLYPHS) {
+		return HAL_ERROR;
+	}
+
+	while (i < len && LCD_SHADOW_CGRAM_IS(lcd, firstLoc * 8 + i, rows[i])) {
+		++i;
+	}
+	if (i == len) {
+		return HAL_OK;
+	}
+
+	// the address counter moves through the CGRAM by itself, so every glyph after the first changed row is sent in one buffer
+	status = LCD_sendInstruction(lcd, LCD_SET_CGRAMADDR | (firstLoc * 8 + i));
+	if (status == HAL_OK) {
+		status = LCD_sendBuffer(lcd, &rows[i], len - i);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Initializes big digits starting at a column and spanning both rows, and loads the glyphs of their font
+ *
+ * @param		big					Pointer to the big digits
+ * @param		lcd					Pointer to LCD structure
+ * @param		font				Pointer to the font (e.g. &LCD_BIG_FONT_3X2)
+ * @param		col					Column of the left-most cell
+ * @param		firstLoc			Location of the first glyph of the font
+ *
+ * @return							Status of the transfers to the LCD, HAL_ERROR if the glyphs do not fit in the CGRAM
+ */
+HAL_StatusTypeDef LCD_initBigDigits(HD44780_LCD_BigDigits_t *big, HD44780_LCD_t *lcd, const HD44780_LCD_BigFont_t *font, uint8_t col,
+		uint8_t firstLoc) {
+	big->lcd = lcd;
+	big->font = font;
+	big->col = col;
+	big->firstLoc = firstLoc;
+	big->end = col;
+
+	return LCD_loadBigFont(lcd, font, firstLoc);
+}
+
+/**
+ * @brief							Draws text with big digits, rewriting only the cells that differ from what is shown (usually those of the digits that changed)
+ *
+ * Digits are separated by the spacing of the font, while ':' and '.' are a single column wide and not separated. A space blanks the width of a
+ * digit, and any other character is skipped. Columns that the previous text covered beyond the end of this one are blanked
+ *
+ * @param		big					Pointer to the big digits
+ * @param		text				Pointer to the text, terminated by '\0' (e.g. "12:34")
+ *
+ * @return							Status of the transfers to the LCD (the draw stops at the first transfer that fails)
+ */
+HAL_StatusTypeDef LCD_drawBigDigits(HD44780_LCD_BigDigits_t *big, const char *text) {
+	const HD44780_LCD_BigFont_t *font = big->font;
+	uint32_t col = big->col;
+	uint8_t digit = 0;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (; *text != '\0' && status == HAL_OK; ++text) {
+		const uint8_t *cells;
+		uint32_t width = font->width;
+
+		if (*text >= '0' && *text <= '9') {
+			cells = &(font->digits[(*text - '0') * 2 * font->width]);
+		} else if (*text == ':' || *text == '.') {
+			cells = (*text == ':') ? (font->colon) : (font->dot);
+			width = 1;
+		} else if (*text == ' ') {
+			cells = NULL;
+		} else {
+			continue;
+		}
+
+		// the gap between two digits (or spaces) is blanked, so a narrower character drawn there before is erased
+		if (width == font->width && digit) {
+			for (uint32_t k = 0; k < font->spacing && status == HAL_OK; ++k, ++col) {
+				status = LCD_drawBigCell(big, 0, col, ' ');
+				if (status == HAL_OK) {
+					status = LCD_drawBigCell(big, 1, col, ' ');
+				}
+			}
+		}
+		digit = (width == font->width);
+
+		for (uint32_t row = 0; row < 2; ++row) {
+			for (uint32_t k = 0; k < width && status == HAL_OK; ++k) {
+				status = LCD_drawBigCell(big, row, col + k, (cells) ? (cells[row * width + k]) : (' '));
+			}
+		}
+		col += width;
+	}
+
+	for (uint32_t c = col; c < big->end && status == HAL_OK; ++c) {
+		status = LCD_drawBigCell(big, 0, c, ' ');
+		if (status == HAL_OK) {
+			status = LCD_drawBigCell(big, 1, c, ' ');
+		}
+	}
+	big->end = col;
+
+	return status;
+}
@@ -0,0 +1,381 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Canvas.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the canvas, a grid of pixels over a rectangle of cells that is cut into glyphs of the CGRAM when it is flushed
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// the number of pixel columns of a cell
+#define   CELL_WIDTH			5
+// the number of pixel rows of a cell
+#define   CELL_HEIGHT			8
+// the row of a cell whose pixels are all set
+#define   ROW_FULL				0x1F
+// marks a cell that shows a character of the ROM, or a glyph that has no location
+#define   NONE					0xFF
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Counts the pixels that differ between two glyphs
+ *
+ * @param		a					Rows of the first glyph
+ * @param		b					Rows of the second glyph
+ *
+ * @return							Number of pixels that differ (0 to 40)
+ */
+static uint32_t LCD_glyphDistance(const uint8_t a[8], const uint8_t b[8]) {
+	uint32_t count = 0;
+
+	for (uint32_t row = 0; row < CELL_HEIGHT; ++row) {
+		for (uint8_t bits = (a[row] ^ b[row]) & ROW_FULL; bits != 0; bits &= bits - 1) {
+			++count;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * @brief							Returns whether two glyphs are identical
+ *
+ * @param		a					Rows of the first glyph
+ * @param		b					Rows of the second glyph
+ *
+ * @return							1 if every row is the same, 0 otherwise
+ */
+static uint8_t LCD_sameGlyph(const uint8_t a[8], const uint8_t b[8]) {
+	for (uint32_t row = 0; row < CELL_HEIGHT; ++row) {
+		if (a[row] != b[row]) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * @brief							Picks the character shown in place of a glyph that did not get a location, according to the fallback of the canvas
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		glyph				Rows of the glyph
+ * @param		locOf				Location of each distinct glyph (NONE if it has none)
+ * @param		first				Index of the first cell showing each distinct glyph
+ * @param		count				Number of distinct glyphs
+ *
+ * @return							Code of the character to show
+ */
+static uint8_t LCD_fallbackCode(const HD44780_LCD_Canvas_t *canvas, const uint8_t glyph[8], const uint8_t *locOf, const uint8_t *first, uint32_t count) {
+	static const uint8_t blank[CELL_HEIGHT] = { 0 };
+	const uint32_t lit = LCD_glyphDistance(glyph, blank);
+	uint32_t best = (lit * 2 >= CELL_WIDTH * CELL_HEIGHT) ? (CELL_WIDTH * CELL_HEIGHT - lit) : (lit);
+	uint8_t code = (lit * 2 >= CELL_WIDTH * CELL_HEIGHT) ? (LCD_ROM_FULL_BLOCK) : (' ');
+
+	if (canvas->fallback == canvasThreshold) {
+		return code;
+	}
+
+	// the glyph is shown as the most similar of the glyphs that got a location, or as a blank or full cell
+	for (uint32_t t = 0; t < count; ++t) {
+		uint32_t distance;
+
+		if (locOf[t] == NONE) {
+			continue;
+		}
+
+		distance = LCD_glyphDistance(glyph, canvas->pixels[first[t]]);
+		if (distance < best) {
+			best = distance;
+			code = locOf[t];
+		}
+	}
+
+	return code;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a blank canvas over a rectangle of cells, whose pixels are numbered from the top-left (without the gaps between cells)
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		lcd					Pointer to LCD structure
+ * @param		row					Row of the top-left cell (0 or 1)
+ * @param		col					Column of the top-left cell
+ * @param		rows				Number of rows of cells (1 or 2)
+ * @param		cols				Number of columns of cells
+ * @param		firstLoc			First location of the CGRAM the canvas may use
+ * @param		locs				Number of locations of the CGRAM the canvas may use
+ * @param		fallback			What is shown in cells whose glyphs do not fit in those locations
+ *
+ * @return							HAL_OK, HAL_ERROR if the canvas has more than LCD_CANVAS_MAX_CELLS cells or its locations are outside the CGRAM
+ */
+HAL_StatusTypeDef LCD_initCanvas(HD44780_LCD_Canvas_t *canvas, HD44780_LCD_t *lcd, uint8_t row, uint8_t col, uint8_t rows, uint8_t cols,
+		uint8_t firstLoc, uint8_t locs, enum HD44780_LCD_CANVAS_FALLBACK fallback) {
+	if (rows == 0 || row + rows > 2 || cols == 0 || rows * cols > LCD_CANVAS_MAX_CELLS || firstLoc + locs > LCD_CGRAM_GLYPHS) {
+		return HAL_ERROR;
+	}
+
+	canvas->lcd = lcd;
+	canvas->row = row;
+	canvas->col = col;
+	canvas->rows = rows;
+	canvas->cols = cols;
+	canvas->firstLoc = firstLoc;
+	canvas->locs = locs;
+	canvas->fallback = fallback;
+
+	LCD_clearCanvas(canvas);
+	return HAL_OK;
+}
+
+/**
+ * @brief							Clears every pixel of a canvas
+ *
+ * @param		canvas				Pointer to the canvas
+ */
+void LCD_clearCanvas(HD44780_LCD_Canvas_t *canvas) {
+	for (uint32_t cell = 0; cell < LCD_CANVAS_MAX_CELLS; ++cell) {
+		for (uint32_t row = 0; row < CELL_HEIGHT; ++row) {
+			canvas->pixels[cell][row] = 0;
+		}
+	}
+	canvas->dirty = 1;
+}
+
+/**
+ * @brief							Sets or clears a pixel of a canvas
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		x					Column of the pixel (pixels outside the canvas are ignored)
+ * @param		y					Row of the pixel
+ * @param		on					Whether the pixel is set (1) or cleared (0)
+ */
+void LCD_setPixel(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, uint8_t on) {
+	uint8_t *row;
+	uint8_t bit;
+
+	if (x < 0 || y < 0 || x >= canvas->cols * CELL_WIDTH || y >= canvas->rows * CELL_HEIGHT) {
+		return;
+	}
+
+	row = &(canvas->pixels[(y / CELL_HEIGHT) * canvas->cols + x / CELL_WIDTH][y % CELL_HEIGHT]);
+	bit = 1U << (CELL_WIDTH - 1 - x % CELL_WIDTH);
+
+	*row = (on) ? (*row | bit) : (*row & ~bit);
+	canvas->dirty = 1;
+}
+
+/**
+ * @brief							Draws a line between two pixels of a canvas (both included)
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		x0					Column of the first pixel
+ * @param		y0					Row of the first pixel
+ * @param		x1					Column of the last pixel
+ * @param		y1					Row of the last pixel
+ * @param		on					Whether the pixels are set (1) or cleared (0)
+ */
+void LCD_drawLine(HD44780_LCD_Canvas_t *canvas, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t on) {
+	const int32_t dx = (x1 > x0) ? (x1 - x0) : (x0 - x1);
+	const int32_t dy = (y1 > y0) ? (y0 - y1) : (y1 - y0);
+	const int32_t sx = (x1 > x0) ? (1) : (-1);
+	const int32_t sy = (y1 > y0) ? (1) : (-1);
+	int32_t err = dx + dy;
+
+	// Bresenham's algorithm, with the error term covering both octants of each quadrant
+	for (;;) {
+		const int32_t err2 = 2 * err;
+
+		LCD_setPixel(canvas, x0, y0, on);
+		if (x0 == x1 && y0 == y1) {
+			break;
+		}
+		if (err2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (err2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+/**
+ * @brief							Draws the outline of a rectangle, or fills it
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		x					Column of the top-left pixel
+ * @param		y					Row of the top-left pixel
+ * @param		w					Width of the rectangle in pixels
+ * @param		h					Height of the rectangle in pixels
+ * @param		on					Whether the pixels are set (1) or cleared (0)
+ * @param		fill				Whether the rectangle is filled (1) or only outlined (0)
+ */
+void LCD_drawRect(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, int32_t w, int32_t h, uint8_t on, uint8_t fill) {
+	for (int32_t j = 0; j < h; ++j) {
+		for (int32_t i = 0; i < w; ++i) {
+			if (fill || i == 0 || j == 0 || i == w - 1 || j == h - 1) {
+				LCD_setPixel(canvas, x + i, y + j, on);
+			}
+		}
+	}
+}
+
+/**
+ * @brief							Copies a bitmap onto a canvas, setting the pixels that are set in the bitmap and clearing the rest
+ *
+ * @param		canvas				Pointer to the canvas
+ * @param		x					Column of the top-left pixel
+ * @param		y					Row of the top-left pixel
+ * @param		bitmap				Pointer to the bitmap, row by row, with (w + 7) / 8 bytes per row (bit 7 of the first byte is the left-most pixel)
+ * @param		w					Width of the bitmap in pixels
+ * @param		h					Height of the bitmap in pixels
+ */
+void LCD_blitCanvas(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, const uint8_t *bitmap, uint32_t w, uint32_t h) {
+	const uint32_t stride = (w + 7) / 8;
+
+	for (uint32_t j = 0; j < h; ++j) {
+		for (uint32_t i = 0; i < w; ++i) {
+			LCD_setPixel(canvas, x + i, y + j, (bitmap[j * stride + i / 8] >> (7 - i % 8)) & 1);
+		}
+	}
+}
+
+/**
+ * @brief							Shows a canvas on the LCD, sending only the glyphs and cells that changed, and returns at once if it was not drawn on since
+ *
+ * The canvas is cut into a glyph per cell. Blank cells show a space and full cells LCD_ROM_FULL_BLOCK from the ROM, and cells with identical
+ * glyphs share a location of the CGRAM. A glyph that a location already holds keeps it, and the rest take the free locations, the glyphs shown by
+ * the most cells first. Cells whose glyphs do not fit show a character picked by the fallback of the canvas: the most similar glyph that fit
+ * (canvasNearest), or a space or full block depending on whether fewer than half of the pixels are set (canvasThreshold)
+ *
+ * @param		canvas				Pointer to the canvas
+ *
+ * @return							Status of the transfers to the LCD (the flush stops at the first transfer that fails)
+ */
+HAL_StatusTypeDef LCD_flushCanvas(HD44780_LCD_Canvas_t *canvas) {
+	HD44780_LCD_t *lcd = canvas->lcd;
+	const uint32_t cells = canvas->rows * canvas->cols;
+	uint8_t first[LCD_CANVAS_MAX_CELLS];			// first cell showing each distinct glyph
+	uint8_t uses[LCD_CANVAS_MAX_CELLS];				// number of cells showing each distinct glyph
+	uint8_t locOf[LCD_CANVAS_MAX_CELLS];			// location of each distinct glyph
+	uint8_t glyphOf[LCD_CANVAS_MAX_CELLS];			// distinct glyph of each cell (NONE for blank and full cells)
+	uint8_t codes[LCD_CANVAS_MAX_CELLS];			// character shown by each cell
+	uint32_t claimed = 0;							// locations taken by a distinct glyph
+	uint32_t count = 0;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	if (!canvas->dirty) {
+		return HAL_OK;
+	}
+
+	for (uint32_t cell = 0; cell < cells; ++cell) {
+		const uint8_t *glyph = canvas->pixels[cell];
+		uint8_t any = 0;
+		uint8_t all = ROW_FULL;
+		uint32_t t;
+
+		for (uint32_t row = 0; row < CELL_HEIGHT; ++row) {
+			any |= glyph[row];
+			all &= glyph[row];
+		}
+
+		glyphOf[cell] = NONE;
+		if (any == 0) {
+			codes[cell] = ' ';
+			continue;
+		}
+		if (all == ROW_FULL) {
+			codes[cell] = LCD_ROM_FULL_BLOCK;
+			continue;
+		}
+
+		for (t = 0; t < count && !LCD_sameGlyph(glyph, canvas->pixels[first[t]]); ++t) {
+		}
+		if (t == count) {
+			first[count] = cell;
+			uses[count] = 0;
+			locOf[count] = NONE;
+			++count;
+		}
+		++uses[t];
+		glyphOf[cell] = t;
+	}
+
+#if LCD_USE_SHADOW
+	// a glyph that a location already holds keeps it, so it is not loaded again
+	for (uint32_t t = 0; t < count; ++t) {
+		for (uint32_t loc = canvas->firstLoc; loc < canvas->firstLoc + canvas->locs; ++loc) {
+			if (!(claimed & (1U << loc)) && LCD_sameGlyph(canvas->pixels[first[t]], &(lcd->shadow.cgram[loc * 8]))) {
+				locOf[t] = loc;
+				claimed |= 1U << loc;
+				break;
+			}
+		}
+	}
+#endif
+
+	// the rest take the free locations, the glyphs shown by the most cells first, and only their changed rows are sent
+	for (;;) {
+		uint32_t best = NONE;
+		uint32_t loc = canvas->firstLoc;
+
+		for (uint32_t t = 0; t < count; ++t) {
+			if (locOf[t] == NONE && (best == NONE || uses[t] > uses[best])) {
+				best = t;
+			}
+		}
+		while (loc < canvas->firstLoc + canvas->locs && (claimed & (1U << loc))) {
+			++loc;
+		}
+		if (best == NONE || loc == canvas->firstLoc + canvas->locs) {
+			break;
+		}
+
+		locOf[best] = loc;
+		claimed |= 1U << loc;
+		if (status == HAL_OK) {
+			status = LCD_updateCustomChar(lcd, loc, canvas->pixels[first[best]]);
+		}
+	}
+
+	for (uint32_t cell = 0; cell < cells; ++cell) {
+		if (glyphOf[cell] == NONE) {
+			continue;
+		}
+		if (locOf[glyphOf[cell]] != NONE) {
+			codes[cell] = locOf[glyphOf[cell]];
+		} else {
+			codes[cell] = LCD_fallbackCode(canvas, canvas->pixels[cell], locOf, first, count);
+		}
+	}
+
+	// the cells are written after the glyphs, so a cell that starts showing a location shows its new glyph at once
+	for (uint32_t cell = 0; cell < cells && status == HAL_OK; ++cell) {
+		const uint32_t row = canvas->row + cell / canvas->cols;
+		const uint32_t col = canvas->col + cell % canvas->cols;
+		const uint8_t addr = ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+
+		if (LCD_SHADOW_DDRAM_IS(lcd, row, col, codes[cell])) {
+			continue;
+		}
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, row, col);
+		}
+		status = LCD_sendData(lcd, codes[cell]);
+	}
+
+	if (status == HAL_OK) {
+		canvas->dirty = 0;
+	}
+
+	return status;
+}
@@ -0,0 +1,326 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Encode.hpp
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the compile-time encoders of the C++ front end, which turn glyphs drawn as text, UTF-8 literals and screens into data placed in flash
+ ******************************************************************************
+ */
+
+#ifndef HD44780_ENCODE_HPP_
+#define HD44780_ENCODE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+#include "HD44780_ROM.h"
+
+namespace hd44780 {
+
+// rows of a glyph of the CGRAM, from the top row down
+using Glyph = std::array<uint8_t, 8>;
+
+// bytes of data that are sent to the LCD together with the frames of a PC8574 Expander that encode them
+template <std::size_t N>
+struct Pcf8574Text {
+	std::array<uint8_t, N> codes;			// codes of the characters, which the shadow buffer is updated with
+	std::array<uint8_t, N * 6> frames;		// bytes sent to the Expander, 6 per code (each nibble with EN low, high and low again)
+};
+
+// screen compiled at build time into the frames of a PC8574 Expander, shown with LCD_initCompiledScreen and LCD_showScreen
+struct Pcf8574Screen {
+	std::array<uint8_t, 2 * LCD_VISIBLE_COLS> cells;				// codes of the cells, the first row followed by the second
+	std::array<uint8_t, 2 * (1 + LCD_VISIBLE_COLS) * 6> stream;		// frames that set the address of each row and write its cells
+};
+
+// pin map of the common PC8574 modules, which LCD_createI2C sets
+inline constexpr HD44780_LCD_ExpanderPins_t pcf8574Pins = { RS_ID, EN_ID, BACKLIGHT_ID, { 4, 5, 6, 7 } };
+
+namespace detail {
+
+// the encoders call these on input they reject, and since they are not constexpr, the compiler reports the call by the name of the function
+void glyphRowMustBeDotsAndHashes();
+void characterIsMissingFromTheRom();
+void textIsMalformedUtf8();
+void rowIsWiderThanTheDisplay();
+
+// UTF-8 literal passed as a template argument, so that the size of the encoded text is known when its type is formed
+template <std::size_t N>
+struct Literal {
+	consteval Literal(const char (&text)[N]) noexcept {
+		for (std::size_t i = 0; i < N; ++i) {
+			bytes[i] = static_cast<uint8_t>(text[i]);
+		}
+	}
+	consteval Literal(const char8_t (&text)[N]) noexcept {
+		for (std::size_t i = 0; i < N; ++i) {
+			bytes[i] = static_cast<uint8_t>(text[i]);
+		}
+	}
+
+	uint8_t bytes[N] = {};		// bytes of the literal, including the terminating '\0'
+};
+
+/**
+ * @brief							Decodes the next character of UTF-8 text (malformed sequences, overlong encodings and surrogates fail to compile)
+ *
+ * @param		bytes				Pointer to the text
+ * @param		len					Number of bytes of the text
+ * @param		pos					Index of the first byte of the character, moved past its last byte
+ *
+ * @return							Code point of the character
+ */
+consteval uint32_t decodeUTF8(const uint8_t *bytes, std::size_t len, std::size_t &pos) {
+	const uint8_t lead = bytes[pos++];
+	const uint32_t follow = (lead < 0x80) ? (0) : (lead < 0xC0) ? (4) : (lead < 0xE0) ? (1) : (lead < 0xF0) ? (2) : (lead < 0xF8) ? (3) : (4);
+	const uint32_t min[4] = { 0x00, 0x80, 0x800, 0x10000 };
+	uint32_t codePoint;
+
+	if (follow == 4) {
+		textIsMalformedUtf8();
+	}
+
+	codePoint = lead & (0x7F >> follow);
+	for (uint32_t i = 0; i < follow; ++i, ++pos) {
+		if (pos == len || (bytes[pos] & 0xC0) != 0x80) {
+			textIsMalformedUtf8();
+		}
+		codePoint = (codePoint << 6) | (bytes[pos] & 0x3F);
+	}
+
+	if (codePoint < min[follow] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+		textIsMalformedUtf8();
+	}
+
+	return codePoint;
+}
+
+/**
+ * @brief							Returns the number of characters of a UTF-8 literal
+ *
+ * @return							Number of characters, without the terminating '\0'
+ */
+template <Literal Text>
+consteval std::size_t lengthUTF8() {
+	const std::size_t len = sizeof(Text.bytes) - 1;
+	std::size_t count = 0;
+
+	for (std::size_t pos = 0; pos < len; ++count) {
+		decodeUTF8(Text.bytes, len, pos);
+	}
+
+	return count;
+}
+
+/**
+ * @brief							Encodes a byte sent to the LCD into the 6 bytes sent to a PC8574 Expander (each nibble with EN low, high and low again)
+ *
+ * @param		frames				Pointer to the 6 bytes
+ * @param		byte				Byte sent to the LCD
+ * @param		isData				Whether the byte is an instruction (false) or Data (true)
+ * @param		pins				Pin map of the Expander
+ * @param		backlight			Whether the backlight is on
+ */
+consteval void encodeFrames(uint8_t *frames, uint8_t byte, bool isData, const HD44780_LCD_ExpanderPins_t &pins, bool backlight) {
+	for (const uint8_t nibble : { HI_NIBBLE(byte), LO_NIBBLE(byte) }) {
+		uint8_t value = ((isData) ? (1 << pins.rs) : (0)) | ((backlight) ? (1 << pins.backlight) : (0));
+
+		for (uint32_t i = 0; i < 4; ++i) {
+			value |= ((nibble >> i) & 1) << pins.data[i];
+		}
+
+		*frames++ = value;
+		*frames++ = value | (1 << pins.en);
+		*frames++ = value;
+	}
+}
+
+} // namespace detail
+
+/**
+ * @brief							Returns the code of a character in a character ROM at compile time, as LCD_romCode does at run time
+ *
+ * Control characters U+0001 to U+000F are kept as codes of the CGRAM (whose 8 locations repeat, so U+0008 shows location 0)
+ *
+ * @param		rom					Character ROM of the LCD
+ * @param		codePoint			Code point of the character
+ *
+ * @return							Code of the character, 0 if the ROM does not have it
+ */
+consteval uint8_t romCode(HD44780_LCD_ROM rom, uint32_t codePoint) {
+	const uint8_t *page = (codePoint < 0x400) ? (LCD_romPages[rom][codePoint >> 7]) : (nullptr);
+
+	if (codePoint >= 0x01 && codePoint <= 0x0F) {
+		return static_cast<uint8_t>(codePoint);
+	}
+	if (page != nullptr) {
+		return page[codePoint & 0x7F];
+	}
+
+	// the halfwidth katakana (U+FF61 to U+FF9F) are in the same order as in the A00 ROM
+	if (rom == romA00 && codePoint >= 0xFF61 && codePoint <= 0xFF9F) {
+		return static_cast<uint8_t>(codePoint - 0xFF61 + 0xA1);
+	}
+
+	for (const auto &symbol : LCD_romSymbols[rom]) {
+		if (symbol.codePoint == codePoint) {
+			return symbol.code;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief							Draws a glyph from rows of text at compile time, '#' for a pixel that is on and '.' (or ' ') for one that is off
+ *
+ * The rows are 5 characters wide, and rows left out at the bottom are blank (e.g. glyph("..#..", ".###.", "#####") is an arrow)
+ *
+ * @param		rows				1 to 8 rows of the glyph, from the top row down
+ *
+ * @return							Rows of the glyph
+ */
+template <std::size_t... N>
+consteval Glyph glyph(const char (&...rows)[N]) {
+	static_assert(sizeof...(N) >= 1 && sizeof...(N) <= 8, "a glyph has 1 to 8 rows");
+	static_assert(((N == 6) && ...), "each row of a glyph is 5 characters wide");
+
+	const char *text[] = { rows... };
+	Glyph result = {};
+
+	for (std::size_t row = 0; row < sizeof...(N); ++row) {
+		for (std::size_t col = 0; col < 5; ++col) {
+			if (text[row][col] == '#') {
+				result[row] |= 1 << (4 - col);
+			} else if (text[row][col] != '.' && text[row][col] != ' ') {
+				detail::glyphRowMustBeDotsAndHashes();
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief							Codes of a UTF-8 literal in a character ROM, encoded at compile time (characters the ROM does not have fail to compile)
+ *
+ * The codes are a constant placed in flash, sent as they are by LCD_sendBuffer (e.g. LCD_sendBuffer(lcd, romText<romA00, "25°C">.data(), 4))
+ *
+ * @tparam		Rom					Character ROM of the LCD
+ * @tparam		Text				UTF-8 literal
+ */
+template <HD44780_LCD_ROM Rom, detail::Literal Text>
+inline constexpr std::array<uint8_t, detail::lengthUTF8<Text>()> romText = []() consteval {
+	std::array<uint8_t, detail::lengthUTF8<Text>()> codes = {};
+	const std::size_t len = sizeof(Text.bytes) - 1;
+	std::size_t pos = 0;
+
+	for (uint8_t &code : codes) {
+		code = romCode(Rom, detail::decodeUTF8(Text.bytes, len, pos));
+		if (code == 0) {
+			detail::characterIsMissingFromTheRom();
+		}
+	}
+
+	return codes;
+}();
+
+/**
+ * @brief							Codes of a UTF-8 literal in a character ROM and the frames of a PC8574 Expander that send them, encoded at compile time
+ *
+ * The frames are a constant placed in flash, sent in a single transfer by LCD_sendFramesI2C, which falls back to sending the codes if the LCD was
+ * given another pin map or its backlight is in the other state
+ *
+ * @tparam		Rom					Character ROM of the LCD
+ * @tparam		Text				UTF-8 literal
+ * @tparam		Pins				Pin map of the Expander
+ * @tparam		Backlight			Whether the backlight is on while the text is sent
+ */
+template <HD44780_LCD_ROM Rom, detail::Literal Text, HD44780_LCD_ExpanderPins_t Pins = pcf8574Pins, bool Backlight = true>
+inline constexpr Pcf8574Text<romText<Rom, Text>.size()> pcf8574Text = []() consteval {
+	Pcf8574Text<romText<Rom, Text>.size()> text = { romText<Rom, Text>, {} };
+	std::size_t pos = 0;
+
+	for (const uint8_t code : text.codes) {
+		detail::encodeFrames(&text.frames[pos], code, true, Pins, Backlight);
+		pos += 6;
+	}
+
+	return text;
+}();
+
+/**
+ * @brief							Screen compiled at build time into the frames of a PC8574 Expander, from a UTF-8 literal for each row
+ *
+ * Rows are padded with spaces to LCD_VISIBLE_COLS characters, and longer ones fail to compile. The screen is placed in flash and shown with
+ * LCD_initCompiledScreen(&screen, &lcd, s.cells.data(), s.stream.data(), s.stream.size()) and LCD_showScreen
+ *
+ * @tparam		Rom					Character ROM of the LCD
+ * @tparam		Row0				UTF-8 literal of the first row
+ * @tparam		Row1				UTF-8 literal of the second row
+ * @tparam		Pins				Pin map of the Expander
+ * @tparam		Backlight			Whether the backlight is on while the screen is shown
+ */
+template <HD44780_LCD_ROM Rom, detail::Literal Row0, detail::Literal Row1, HD44780_LCD_ExpanderPins_t Pins = pcf8574Pins, bool Backlight = true>
+inline constexpr Pcf8574Screen pcf8574Screen = []() consteval {
+	const std::array<uint8_t, romText<Rom, Row0>.size()> &row0 = romText<Rom, Row0>;
+	const std::array<uint8_t, romText<Rom, Row1>.size()> &row1 = romText<Rom, Row1>;
+	Pcf8574Screen screen = {};
+	std::size_t pos = 0;
+
+	if (row0.size() > LCD_VISIBLE_COLS || row1.size() > LCD_VISIBLE_COLS) {
+		detail::rowIsWiderThanTheDisplay();
+	}
+
+	for (std::size_t col = 0; col < LCD_VISIBLE_COLS; ++col) {
+		screen.cells[col] = (col < row0.size()) ? (row0[col]) : (' ');
+		screen.cells[LCD_VISIBLE_COLS + col] = (col < row1.size()) ? (row1[col]) : (' ');
+	}
+
+	for (std::size_t row = 0; row < 2; ++row) {
+		detail::encodeFrames(&screen.stream[pos], LCD_SET_DDRAMADDR | ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)), false, Pins, Backlight);
+		pos += 6;
+
+		for (std::size_t col = 0; col < LCD_VISIBLE_COLS; ++col) {
+			detail::encodeFrames(&screen.stream[pos], screen.cells[row * LCD_VISIBLE_COLS + col], true, Pins, Backlight);
+			pos += 6;
+		}
+	}
+
+	return screen;
+}();
+
+/**
+ * @brief							Sends codes encoded at compile time at the position of the cursor
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		codes				Codes of the characters (e.g. romText<romA02, "Grüße">)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+template <std::size_t N>
+inline HAL_StatusTypeDef send(HD44780_LCD_t *lcd, const std::array<uint8_t, N> &codes) noexcept {
+	return LCD_sendBuffer(lcd, codes.data(), N);
+}
+
+#if LCD_USE_I2C
+/**
+ * @brief							Sends the frames of text encoded at compile time at the position of the cursor, in a single transfer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		text				Codes and frames of the text (e.g. pcf8574Text<romA00, "25°C">)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+template <std::size_t N>
+inline HAL_StatusTypeDef send(HD44780_LCD_t *lcd, const Pcf8574Text<N> &text) noexcept {
+	return LCD_sendFramesI2C(lcd, text.frames.data(), text.codes.data(), N);
+}
+#endif
+
+} // namespace hd44780
+
+#endif /* HD44780_ENCODE_HPP_ */
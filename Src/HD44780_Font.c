@@ -0,0 +1,270 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Font.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the built-in 5x8 font (ASCII, along with Latin-1 letters and symbols and Greek), from which glyphs are drawn into the Character Generator RAM
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// each character is 5 columns from left to right, and bit r of a column is row r from the top (row 7 is left blank for the cursor)
+static const uint8_t LCD_font[LCD_FONT_LAST - LCD_FONT_FIRST + 1][5] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00 },		// space
+	{ 0x00, 0x00, 0x5F, 0x00, 0x00 },		// !
+	{ 0x00, 0x07, 0x00, 0x07, 0x00 },		// "
+	{ 0x14, 0x7F, 0x14, 0x7F, 0x14 },		// #
+	{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 },		// $
+	{ 0x23, 0x13, 0x08, 0x64, 0x62 },		// %
+	{ 0x36, 0x49, 0x55, 0x22, 0x50 },		// &
+	{ 0x00, 0x05, 0x03, 0x00, 0x00 },		// quote
+	{ 0x00, 0x1C, 0x22, 0x41, 0x00 },		// (
+	{ 0x00, 0x41, 0x22, 0x1C, 0x00 },		// )
+	{ 0x08, 0x2A, 0x1C, 0x2A, 0x08 },		// *
+	{ 0x08, 0x08, 0x3E, 0x08, 0x08 },		// +
+	{ 0x00, 0x50, 0x30, 0x00, 0x00 },		// ,
+	{ 0x08, 0x08, 0x08, 0x08, 0x08 },		// -
+	{ 0x00, 0x60, 0x60, 0x00, 0x00 },		// .
+	{ 0x20, 0x10, 0x08, 0x04, 0x02 },		// /
+	{ 0x3E, 0x51, 0x49, 0x45, 0x3E },		// 0
+	{ 0x00, 0x42, 0x7F, 0x40, 0x00 },		// 1
+	{ 0x42, 0x61, 0x51, 0x49, 0x46 },		// 2
+	{ 0x21, 0x41, 0x45, 0x4B, 0x31 },		// 3
+	{ 0x18, 0x14, 0x12, 0x7F, 0x10 },		// 4
+	{ 0x27, 0x45, 0x45, 0x45, 0x39 },		// 5
+	{ 0x3C, 0x4A, 0x49, 0x49, 0x30 },		// 6
+	{ 0x01, 0x71, 0x09, 0x05, 0x03 },		// 7
+	{ 0x36, 0x49, 0x49, 0x49, 0x36 },		// 8
+	{ 0x06, 0x49, 0x49, 0x29, 0x1E },		// 9
+	{ 0x00, 0x36, 0x36, 0x00, 0x00 },		// :
+	{ 0x00, 0x56, 0x36, 0x00, 0x00 },		// ;
+	{ 0x08, 0x14, 0x22, 0x41, 0x00 },		// <
+	{ 0x14, 0x14, 0x14, 0x14, 0x14 },		// =
+	{ 0x00, 0x41, 0x22, 0x14, 0x08 },		// >
+	{ 0x02, 0x01, 0x51, 0x09, 0x06 },		// ?
+	{ 0x32, 0x49, 0x79, 0x41, 0x3E },		// @
+	{ 0x7E, 0x11, 0x11, 0x11, 0x7E },		// A
+	{ 0x7F, 0x49, 0x49, 0x49, 0x36 },		// B
+	{ 0x3E, 0x41, 0x41, 0x41, 0x22 },		// C
+	{ 0x7F, 0x41, 0x41, 0x22, 0x1C },		// D
+	{ 0x7F, 0x49, 0x49, 0x49, 0x41 },		// E
+	{ 0x7F, 0x09, 0x09, 0x01, 0x01 },		// F
+	{ 0x3E, 0x41, 0x41, 0x51, 0x32 },		// G
+	{ 0x7F, 0x08, 0x08, 0x08, 0x7F },		// H
+	{ 0x00, 0x41, 0x7F, 0x41, 0x00 },		// I
+	{ 0x20, 0x40, 0x41, 0x3F, 0x01 },		// J
+	{ 0x7F, 0x08, 0x14, 0x22, 0x41 },		// K
+	{ 0x7F, 0x40, 0x40, 0x40, 0x40 },		// L
+	{ 0x7F, 0x02, 0x04, 0x02, 0x7F },		// M
+	{ 0x7F, 0x04, 0x08, 0x10, 0x7F },		// N
+	{ 0x3E, 0x41, 0x41, 0x41, 0x3E },		// O
+	{ 0x7F, 0x09, 0x09, 0x09, 0x06 },		// P
+	{ 0x3E, 0x41, 0x51, 0x21, 0x5E },		// Q
+	{ 0x7F, 0x09, 0x19, 0x29, 0x46 },		// R
+	{ 0x46, 0x49, 0x49, 0x49, 0x31 },		// S
+	{ 0x01, 0x01, 0x7F, 0x01, 0x01 },		// T
+	{ 0x3F, 0x40, 0x40, 0x40, 0x3F },		// U
+	{ 0x1F, 0x20, 0x40, 0x20, 0x1F },		// V
+	{ 0x7F, 0x20, 0x18, 0x20, 0x7F },		// W
+	{ 0x63, 0x14, 0x08, 0x14, 0x63 },		// X
+	{ 0x03, 0x04, 0x78, 0x04, 0x03 },		// Y
+	{ 0x61, 0x51, 0x49, 0x45, 0x43 },		// Z
+	{ 0x00, 0x00, 0x7F, 0x41, 0x41 },		// [
+	{ 0x02, 0x04, 0x08, 0x10, 0x20 },		// backslash
+	{ 0x41, 0x41, 0x7F, 0x00, 0x00 },		// ]
+	{ 0x04, 0x02, 0x01, 0x02, 0x04 },		// ^
+	{ 0x40, 0x40, 0x40, 0x40, 0x40 },		// _
+	{ 0x00, 0x01, 0x02, 0x04, 0x00 },		// `
+	{ 0x20, 0x54, 0x54, 0x54, 0x78 },		// a
+	{ 0x7F, 0x48, 0x44, 0x44, 0x38 },		// b
+	{ 0x38, 0x44, 0x44, 0x44, 0x20 },		// c
+	{ 0x38, 0x44, 0x44, 0x48, 0x7F },		// d
+	{ 0x38, 0x54, 0x54, 0x54, 0x18 },		// e
+	{ 0x08, 0x7E, 0x09, 0x01, 0x02 },		// f
+	{ 0x08, 0x14, 0x54, 0x54, 0x3C },		// g
+	{ 0x7F, 0x08, 0x04, 0x04, 0x78 },		// h
+	{ 0x00, 0x44, 0x7D, 0x40, 0x00 },		// i
+	{ 0x20, 0x40, 0x44, 0x3D, 0x00 },		// j
+	{ 0x00, 0x7F, 0x10, 0x28, 0x44 },		// k
+	{ 0x00, 0x41, 0x7F, 0x40, 0x00 },		// l
+	{ 0x7C, 0x04, 0x18, 0x04, 0x78 },		// m
+	{ 0x7C, 0x08, 0x04, 0x04, 0x78 },		// n
+	{ 0x38, 0x44, 0x44, 0x44, 0x38 },		// o
+	{ 0x7C, 0x14, 0x14, 0x14, 0x08 },		// p
+	{ 0x08, 0x14, 0x14, 0x18, 0x7C },		// q
+	{ 0x7C, 0x08, 0x04, 0x04, 0x08 },		// r
+	{ 0x48, 0x54, 0x54, 0x54, 0x20 },		// s
+	{ 0x04, 0x3F, 0x44, 0x40, 0x20 },		// t
+	{ 0x3C, 0x40, 0x40, 0x20, 0x7C },		// u
+	{ 0x1C, 0x20, 0x40, 0x20, 0x1C },		// v
+	{ 0x3C, 0x40, 0x30, 0x40, 0x3C },		// w
+	{ 0x44, 0x28, 0x10, 0x28, 0x44 },		// x
+	{ 0x0C, 0x50, 0x50, 0x50, 0x3C },		// y
+	{ 0x44, 0x64, 0x54, 0x4C, 0x44 },		// z
+	{ 0x00, 0x08, 0x36, 0x41, 0x00 },		// {
+	{ 0x00, 0x00, 0x7F, 0x00, 0x00 },		// |
+	{ 0x00, 0x41, 0x36, 0x08, 0x00 },		// }
+	{ 0x02, 0x01, 0x02, 0x04, 0x02 },		// ~
+};
+
+// characters beyond ASCII (e.g. those of UTF-8 text that the ROM of the LCD does not have), sorted by their code points
+static const struct {
+	uint16_t codePoint;
+	uint8_t columns[5];
+} LCD_fontExtra[] = {
+	{ 0x00A7, { 0x4A, 0x55, 0x55, 0x29, 0x00 } },		// §
+	{ 0x00B0, { 0x06, 0x09, 0x09, 0x06, 0x00 } },		// °
+	{ 0x00B1, { 0x44, 0x44, 0x5F, 0x44, 0x44 } },		// ±
+	{ 0x00B2, { 0x00, 0x19, 0x15, 0x12, 0x00 } },		// ²
+	{ 0x00B3, { 0x00, 0x11, 0x15, 0x0A, 0x00 } },		// ³
+	{ 0x00B5, { 0x7C, 0x20, 0x00, 0x30, 0x1C } },		// µ
+	{ 0x00C4, { 0x78, 0x15, 0x12, 0x15, 0x78 } },		// Ä
+	{ 0x00D6, { 0x3D, 0x42, 0x42, 0x42, 0x3D } },		// Ö
+	{ 0x00DC, { 0x3D, 0x40, 0x40, 0x40, 0x3D } },		// Ü
+	{ 0x00DF, { 0x7E, 0x01, 0x49, 0x36, 0x00 } },		// ß
+	{ 0x00E0, { 0x20, 0x55, 0x56, 0x54, 0x78 } },		// à
+	{ 0x00E4, { 0x20, 0x55, 0x54, 0x55, 0x78 } },		// ä
+	{ 0x00E7, { 0x0C, 0x52, 0x72, 0x12, 0x08 } },		// ç
+	{ 0x00E8, { 0x38, 0x55, 0x56, 0x54, 0x18 } },		// è
+	{ 0x00E9, { 0x38, 0x54, 0x56, 0x55, 0x18 } },		// é
+	{ 0x00F1, { 0x7E, 0x09, 0x05, 0x06, 0x79 } },		// ñ
+	{ 0x00F6, { 0x38, 0x45, 0x44, 0x45, 0x38 } },		// ö
+	{ 0x00FC, { 0x3C, 0x41, 0x40, 0x21, 0x7C } },		// ü
+	{ 0x0393, { 0x7F, 0x01, 0x01, 0x01, 0x01 } },		// Γ
+	{ 0x0394, { 0x70, 0x4C, 0x43, 0x4C, 0x70 } },		// Δ
+	{ 0x0398, { 0x3E, 0x49, 0x49, 0x49, 0x3E } },		// Θ
+	{ 0x039B, { 0x78, 0x06, 0x01, 0x06, 0x78 } },		// Λ
+	{ 0x039E, { 0x41, 0x49, 0x49, 0x49, 0x41 } },		// Ξ
+	{ 0x03A0, { 0x7F, 0x01, 0x01, 0x01, 0x7F } },		// Π
+	{ 0x03A3, { 0x63, 0x55, 0x49, 0x41, 0x41 } },		// Σ
+	{ 0x03A6, { 0x1C, 0x22, 0x7F, 0x22, 0x1C } },		// Φ
+	{ 0x03A8, { 0x07, 0x08, 0x7F, 0x08, 0x07 } },		// Ψ
+	{ 0x03A9, { 0x4E, 0x71, 0x01, 0x71, 0x4E } },		// Ω
+	{ 0x03B1, { 0x38, 0x44, 0x44, 0x38, 0x44 } },		// α
+	{ 0x03B2, { 0x7E, 0x25, 0x25, 0x1A, 0x00 } },		// β
+	{ 0x03B3, { 0x04, 0x08, 0x70, 0x08, 0x04 } },		// γ
+	{ 0x03B4, { 0x32, 0x4D, 0x49, 0x30, 0x00 } },		// δ
+	{ 0x03B5, { 0x28, 0x54, 0x54, 0x44, 0x00 } },		// ε
+	{ 0x03B6, { 0x11, 0x29, 0x25, 0x23, 0x41 } },		// ζ
+	{ 0x03B7, { 0x3C, 0x08, 0x04, 0x04, 0x78 } },		// η
+	{ 0x03B8, { 0x3E, 0x49, 0x49, 0x3E, 0x00 } },		// θ
+	{ 0x03B9, { 0x00, 0x3C, 0x40, 0x40, 0x00 } },		// ι
+	{ 0x03BA, { 0x7C, 0x10, 0x28, 0x44, 0x00 } },		// κ
+	{ 0x03BB, { 0x61, 0x16, 0x08, 0x10, 0x60 } },		// λ
+	{ 0x03BC, { 0x7C, 0x20, 0x00, 0x30, 0x1C } },		// μ
+	{ 0x03BD, { 0x1C, 0x20, 0x40, 0x20, 0x1C } },		// ν
+	{ 0x03BE, { 0x0A, 0x15, 0x55, 0x55, 0x20 } },		// ξ
+	{ 0x03C0, { 0x04, 0x7C, 0x04, 0x3C, 0x44 } },		// π
+	{ 0x03C1, { 0x78, 0x24, 0x24, 0x24, 0x18 } },		// ρ
+	{ 0x03C2, { 0x0C, 0x12, 0x52, 0x52, 0x20 } },		// ς
+	{ 0x03C3, { 0x38, 0x44, 0x44, 0x4C, 0x34 } },		// σ
+	{ 0x03C4, { 0x04, 0x04, 0x3C, 0x44, 0x44 } },		// τ
+	{ 0x03C5, { 0x3C, 0x40, 0x40, 0x40, 0x3C } },		// υ
+	{ 0x03C6, { 0x18, 0x24, 0x7E, 0x24, 0x18 } },		// φ
+	{ 0x03C7, { 0x44, 0x28, 0x10, 0x28, 0x44 } },		// χ
+	{ 0x03C8, { 0x0E, 0x10, 0x7E, 0x10, 0x0E } },		// ψ
+	{ 0x03C9, { 0x38, 0x44, 0x30, 0x44, 0x38 } },		// ω
+	{ 0x20AC, { 0x14, 0x3E, 0x55, 0x55, 0x41 } },		// €
+};
+
+// columns of characters the font does not have
+static const uint8_t LCD_fontBlank[5] = { 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Turns the columns of a character into the rows of a glyph
+ *
+ * @param		columns				Columns of the character, from left to right (bit r of a column is row r from the top)
+ * @param		glyph				Rows of the glyph, from the top (bit 4 of a row is its left-most pixel)
+ */
+static void LCD_columnsToGlyph(const uint8_t columns[5], uint8_t glyph[8]) {
+	for (uint32_t row = 0; row < 8; ++row) {
+		uint8_t bits = 0;
+
+		for (uint32_t col = 0; col < 5; ++col) {
+			bits = (bits << 1) | ((columns[col] >> row) & 1);
+		}
+		glyph[row] = bits;
+	}
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Returns the columns of a character of the built-in font
+ *
+ * @param		ch					Character (LCD_FONT_FIRST to LCD_FONT_LAST, others are blank)
+ *
+ * @return							Pointer to the 5 columns of the character, from left to right (bit r of a column is row r from the top)
+ */
+const uint8_t *LCD_fontColumns(uint8_t ch) {
+	if (ch < LCD_FONT_FIRST || ch > LCD_FONT_LAST) {
+		return LCD_fontBlank;
+	}
+
+	return LCD_font[ch - LCD_FONT_FIRST];
+}
+
+/**
+ * @brief							Draws a character of the built-in font as the rows of a glyph, as taken by LCD_createCustomChar
+ *
+ * @param		ch					Character (LCD_FONT_FIRST to LCD_FONT_LAST, others are blank)
+ * @param		glyph				Rows of the glyph, from the top (bit 4 of a row is its left-most pixel)
+ */
+void LCD_fontGlyph(uint8_t ch, uint8_t glyph[8]) {
+	LCD_columnsToGlyph(LCD_fontColumns(ch), glyph);
+}
+
+/**
+ * @brief							Returns the columns of a character of the built-in font by its Unicode code point, including the characters beyond ASCII
+ *
+ * @param		codePoint			Code point of the character
+ *
+ * @return							Pointer to the 5 columns of the character, NULL if the font does not have it
+ */
+const uint8_t *LCD_fontCodePoint(uint32_t codePoint) {
+	uint32_t lo = 0;
+	uint32_t hi = sizeof(LCD_fontExtra) / sizeof(LCD_fontExtra[0]);
+
+	if (codePoint >= LCD_FONT_FIRST && codePoint <= LCD_FONT_LAST) {
+		return LCD_font[codePoint - LCD_FONT_FIRST];
+	}
+
+	while (lo < hi) {
+		const uint32_t mid = (lo + hi) / 2;
+
+		if (LCD_fontExtra[mid].codePoint == codePoint) {
+			return LCD_fontExtra[mid].columns;
+		}
+		if (LCD_fontExtra[mid].codePoint < codePoint) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief							Draws a character of the built-in font by its Unicode code point as the rows of a glyph
+ *
+ * @param		codePoint			Code point of the character
+ * @param		glyph				Rows of the glyph, from the top (left unchanged if the font does not have the character)
+ *
+ * @return							1 if the font has the character, 0 otherwise
+ */
+uint8_t LCD_fontCodePointGlyph(uint32_t codePoint, uint8_t glyph[8]) {
+	const uint8_t *columns = LCD_fontCodePoint(codePoint);
+
+	if (columns == NULL) {
+		return 0;
+	}
+
+	LCD_columnsToGlyph(columns, glyph);
+	return 1;
+}
@@ -0,0 +1,165 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Frame.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the frame into which cells of the LCD are written from any context, and which a single background flusher sends to the LCD
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if (LCD_FRAME_GROUP & (LCD_FRAME_GROUP - 1)) != 0 || (LCD_LINE_SIZE % LCD_FRAME_GROUP) != 0
+#error "LCD_FRAME_GROUP must be a power of 2 that divides LCD_LINE_SIZE"
+#endif
+
+// get the index of the dirty flag of a cell
+#define   GROUP_OF(row, col)	(((row) * LCD_LINE_SIZE + (col)) / LCD_FRAME_GROUP)
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Sends the cells of a group of the frame that differ from the shadow buffer of the LCD, moving the cursor only when the cell does not follow the last one written
+ *
+ * @param		frame				Pointer to the frame
+ * @param		group				Index of the group
+ * @param		max					Maximum number of cells to send
+ *
+ * @return							Number of cells sent (if it equals max, cells of the group may still differ)
+ */
+static uint32_t LCD_flushGroup(HD44780_LCD_Frame_t *frame, uint32_t group, uint32_t max) {
+	HD44780_LCD_t *lcd = frame->lcd;
+	const uint32_t row = (group * LCD_FRAME_GROUP) / LCD_LINE_SIZE;
+	const uint32_t first = (group * LCD_FRAME_GROUP) % LCD_LINE_SIZE;
+	uint32_t sent = 0;
+
+	for (uint32_t col = first; col < first + LCD_FRAME_GROUP && sent < max; ++col) {
+		const uint8_t data = frame->cells[row][col];
+		const uint8_t addr = ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+
+		if (LCD_SHADOW_DDRAM_IS(lcd, row, col, data)) {
+			continue;
+		}
+
+		// the shadow buffer follows the address counter, so consecutive cells need no cursor movement
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, row, col);
+		}
+		LCD_sendData(lcd, data);
+		++sent;
+	}
+
+	return sent;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a frame with the contents of the DDRAM of the LCD, as recorded by its shadow buffer (spaces if it is compiled out)
+ *
+ * Cells are written to the frame from any context with single-byte stores, and a single flusher (e.g. the main loop or a timer interrupt) sends
+ * the cells that changed to the LCD with LCD_flushFrame. The LCD must be initialized before the frame is flushed, and must not be written to
+ * directly in the meantime, since the flusher moves the cursor
+ *
+ * @param		frame				Pointer to the frame (usually statically allocated)
+ * @param		lcd					Pointer to LCD structure
+ */
+void LCD_initFrame(HD44780_LCD_Frame_t *frame, HD44780_LCD_t *lcd) {
+	frame->lcd = lcd;
+
+	for (uint32_t row = 0; row < 2; ++row) {
+		for (uint32_t col = 0; col < LCD_LINE_SIZE; ++col) {
+#if LCD_USE_SHADOW
+			frame->cells[row][col] = lcd->shadow.ddram[row][col];
+#else
+			frame->cells[row][col] = ' ';
+#endif
+		}
+	}
+	for (uint32_t group = 0; group < LCD_FRAME_GROUPS; ++group) {
+		frame->dirty[group] = 0;
+	}
+	frame->pending = 0;
+}
+
+/**
+ * @brief							Writes a single cell of the frame, which never blocks and can be called from any context, including interrupt handlers
+ *
+ * The cell and its dirty flag are each written with a single-byte store, which the Cortex-M0+ makes atomic without exclusive accesses or masking interrupts
+ *
+ * @param		frame				Pointer to the frame
+ * @param		row					Row of the cell (0 or 1)
+ * @param		col					Column of the cell (0 to LCD_LINE_SIZE-1, cells beyond are ignored)
+ * @param		data				Data to write to the cell
+ */
+void LCD_writeCell(HD44780_LCD_Frame_t *frame, uint8_t row, uint8_t col, uint8_t data) {
+	if (row > 1 || col >= LCD_LINE_SIZE) {
+		return;
+	}
+
+	frame->cells[row][col] = data;
+
+	// the flusher clears the flags before reading the cells, so a cell written during a flush is sent again by the next one
+	__DMB();
+	frame->dirty[GROUP_OF(row, col)] = 1;
+	frame->pending = 1;
+}
+
+/**
+ * @brief							Writes consecutive cells of a row of the frame, which never blocks and can be called from any context, including interrupt handlers
+ *
+ * Each cell is written on its own, so a flush that runs in the middle of the call may send only some of them (the rest are sent by the next flush)
+ *
+ * @param		frame				Pointer to the frame
+ * @param		row					Row of the first cell (0 or 1)
+ * @param		col					Column of the first cell
+ * @param		buf					Pointer to the data to write to the cells
+ * @param		len					Number of cells (cells beyond the end of the row are ignored)
+ */
+void LCD_writeCells(HD44780_LCD_Frame_t *frame, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len) {
+	for (uint32_t i = 0; i < len && col + i < LCD_LINE_SIZE; ++i) {
+		LCD_writeCell(frame, row, col + i, buf[i]);
+	}
+}
+
+/**
+ * @brief							Sends the cells of the frame that differ from the contents of the LCD, and must be called periodically from a single context (e.g. the main loop)
+ *
+ * @param		frame				Pointer to the frame
+ * @param		max					Maximum number of cells to send, which bounds the time spent (the rest are sent by later calls)
+ *
+ * @return							Number of cells that were sent
+ */
+uint32_t LCD_flushFrame(HD44780_LCD_Frame_t *frame, uint32_t max) {
+	uint32_t sent = 0;
+
+	if (!frame->pending) {
+		return 0;
+	}
+	frame->pending = 0;
+
+	for (uint32_t group = 0; group < LCD_FRAME_GROUPS; ++group) {
+		if (!frame->dirty[group]) {
+			continue;
+		}
+
+		// the group is left dirty for the next call once the limit is reached
+		if (sent >= max) {
+			frame->pending = 1;
+			break;
+		}
+
+		frame->dirty[group] = 0;
+		__DMB();
+
+		sent += LCD_flushGroup(frame, group, max - sent);
+		if (sent >= max) {
+			frame->dirty[group] = 1;
+			frame->pending = 1;
+		}
+	}
+
+	return sent;
+}
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Glyphs.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the glyph cache, which shares locations of the CGRAM between widgets by the glyphs they hold and loads each glyph only once
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Returns whether a location of the CGRAM holds a glyph, according to the shadow buffer (or the copy the cache keeps without it)
+ *
+ * @param		cache				Pointer to the glyph cache
+ * @param		loc					Location of the CGRAM
+ * @param		glyph				Rows of the glyph
+ *
+ * @return							1 if every row is the same, 0 otherwise
+ */
+static uint8_t LCD_holdsGlyph(const HD44780_LCD_GlyphCache_t *cache, uint32_t loc, const uint8_t glyph[8]) {
+#if !LCD_USE_SHADOW
+	if (!(cache->loaded & (1U << loc))) {
+		return 0;
+	}
+#endif
+
+	for (uint32_t row = 0; row < 8; ++row) {
+#if LCD_USE_SHADOW
+		if (!LCD_SHADOW_CGRAM_IS(cache->lcd, loc * 8 + row, glyph[row])) {
+#else
+		if (cache->glyphs[loc][row] != glyph[row]) {
+#endif
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a glyph cache over a range of locations of the CGRAM, all of which start out free
+ *
+ * Widgets acquire the glyphs they show from the cache instead of loading them into fixed locations, so widgets that show the same glyphs share
+ * their locations, and a glyph that a location already holds is not loaded again
+ *
+ * @param		cache				Pointer to the glyph cache
+ * @param		lcd					Pointer to LCD structure
+ * @param		firstLoc			First location of the CGRAM the cache manages
+ * @param		locs				Number of locations of the CGRAM the cache manages
+ *
+ * @return							HAL_OK, HAL_ERROR if the locations are outside the CGRAM
+ */
+HAL_StatusTypeDef LCD_initGlyphCache(HD44780_LCD_GlyphCache_t *cache, HD44780_LCD_t *lcd, uint8_t firstLoc, uint8_t locs) {
+	if (firstLoc + locs > LCD_CGRAM_GLYPHS) {
+		return HAL_ERROR;
+	}
+
+	cache->lcd = lcd;
+	cache->firstLoc = firstLoc;
+	cache->locs = locs;
+	cache->clock = 0;
+#if !LCD_USE_SHADOW
+	cache->loaded = 0;
+#endif
+
+	for (uint32_t loc = 0; loc < LCD_CGRAM_GLYPHS; ++loc) {
+		cache->refs[loc] = 0;
+		cache->released[loc] = 0;
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Acquires a location of the CGRAM that holds a glyph, loading the glyph only if no location of the cache holds it yet
+ *
+ * A location that holds the glyph is shared, whether other users hold it or not. Otherwise the glyph is loaded into the free location that was
+ * released the longest time ago, sending only the rows that differ from what it held. Without the shadow buffer (LCD_USE_SHADOW 0), the cache compares
+ * glyphs with a copy of the rows it loaded, so its locations must not be loaded other than through it
+ *
+ * @param		cache				Pointer to the glyph cache
+ * @param		glyph				Rows of the glyph
+ * @param		loc					Location of the glyph, a code of the DDRAM that shows it (written unless HAL_BUSY is returned)
+ *
+ * @return							Status of the transfers to the LCD, HAL_BUSY if every location of the cache is held by another glyph
+ */
+HAL_StatusTypeDef LCD_acquireGlyph(HD44780_LCD_GlyphCache_t *cache, const uint8_t glyph[8], uint8_t *loc) {
+	const uint32_t end = cache->firstLoc + cache->locs;
+	uint32_t victim = end;
+
+	for (uint32_t l = cache->firstLoc; l < end; ++l) {
+		if (LCD_holdsGlyph(cache, l, glyph)) {
+			++cache->refs[l];
+			*loc = l;
+			return HAL_OK;
+		}
+	}
+
+	// locations are compared by how long ago they were released (the clock wraps around, so by their difference)
+	for (uint32_t l = cache->firstLoc; l < end; ++l) {
+		if (cache->refs[l] == 0 && (victim == end || (uint16_t) (cache->clock - cache->released[l]) > (uint16_t) (cache->clock - cache->released[victim]))) {
+			victim = l;
+		}
+	}
+
+	if (victim == end) {
+		return HAL_BUSY;
+	}
+
+	cache->refs[victim] = 1;
+	*loc = victim;
+
+#if LCD_USE_SHADOW
+	return LCD_updateCustomChar(cache->lcd, victim, glyph);
+#else
+	HAL_StatusTypeDef status = LCD_updateCustomChar(cache->lcd, victim, glyph);
+
+	// a location whose glyph was not loaded completely holds unknown rows until it is loaded again
+	cache->loaded &= ~(1U << victim);
+	if (status == HAL_OK) {
+		for (uint32_t row = 0; row < 8; ++row) {
+			cache->glyphs[victim][row] = glyph[row];
+		}
+		cache->loaded |= 1U << victim;
+	}
+
+	return status;
+#endif
+}
+
+/**
+ * @brief							Releases a location acquired from a glyph cache, which keeps its glyph until the location is given to another one
+ *
+ * Cells that show the glyph keep showing it until the location is reloaded, so they should be rewritten before it is released
+ *
+ * @param		cache				Pointer to the glyph cache
+ * @param		loc					Location of the glyph
+ */
+void LCD_releaseGlyph(HD44780_LCD_GlyphCache_t *cache, uint8_t loc) {
+	if (loc < LCD_CGRAM_GLYPHS && cache->refs[loc] != 0 && --cache->refs[loc] == 0) {
+		cache->released[loc] = ++cache->clock;
+	}
+}
@@ -11,437 +11,1887 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32g0xx_hal.h"
 #include "HD44780_LCD.h"
+#if LCD_USE_LL
+#include "stm32g0xx_ll_i2c.h"
+#endif
+
+// Alias to refer to the pin connected to the Data pin of the Shift Register (this is used when the LCD is operated by the shift register)
+#define   DATA_PIN          	dataPins[0]
+// Alias to refer to the pin connected to the Clock pin of the Shift Register (this is used when the LCD is operated by the shift register)
+#define   CLOCK_PIN          	dataPins[1]
+// Alias to refer to the pin connected to the Latch pin of the Shift Register (this is used when the LCD is operated by the shift register)
+#define   LATCH_PIN          	dataPins[2]
+
+// half of the period of the clock generated while recovering the I2C bus, in microseconds
+#define   I2C_HALF_PERIOD_US	((500000 + LCD_I2C_BUS_HZ - 1) / LCD_I2C_BUS_HZ)
+// the largest number of bytes the I2C peripheral counts at a time (NBYTES of CR2), beyond which a transfer is continued in reload mode
+#define   I2C_MAX_NBYTES		255
+
+// the number of addresses probed while searching for an I2C Expander (8 PC8574 addresses followed by 8 PC8574A addresses)
+#define   PROBE_ADDR_COUNT		16
+// the probe ordinal of an LCD whose I2C Expander is at a fixed address (it is not searched for when re-attaching)
+#define   PROBE_FIXED			0xFF
+
+// the number of ticks of HAL_GetTick that are certain to span the given number of microseconds
+#define   US_TO_TICKS(us)		(((uint32_t)(us) + 999U) / 1000U + 1U)
+
+// the mask of the bits of the address counter when it points into the CGRAM
+#define   CGRAM_ADDR_MASK		(LCD_CGRAM_SIZE - 1)
+// the mask of the bits of the address counter when it points into the DDRAM
+#define   DDRAM_ADDR_MASK		0x7F
+
+/** Private Functions --------------------------------------------------------*/
+
+#if LCD_USE_I2C
+/**
+ * @brief							Releases a stuck I2C bus by clocking out up to 9 bits and generating a STOP condition, after which the I2C peripheral is re-initialized
+ *
+ * If the recovery pins have not been set, only the I2C peripheral is re-initialized
+ *
+ * @param		lcd					Pointer to LCD structure
+ */
+static void LCD_clearI2CBus(HD44780_LCD_t *lcd) {
+	GPIO_InitTypeDef gpio = {0};
+
+	// release the pins from the peripheral so that they can be driven manually
+	HAL_I2C_DeInit(lcd->I2CHandle);
+	++lcd->I2CStats.recoveries;
+
+	if (lcd->sclPin.port != LCD_PORT_NONE && lcd->sdaPin.port != LCD_PORT_NONE) {
+		LCD_WRITE_PIN(lcd->sclPin, GPIO_PIN_SET);
+		LCD_WRITE_PIN(lcd->sdaPin, GPIO_PIN_SET);
+
+		gpio.Mode = GPIO_MODE_OUTPUT_OD;
+		gpio.Pull = GPIO_NOPULL;
+		gpio.Speed = GPIO_SPEED_FREQ_LOW;
+
+		gpio.Pin = LCD_PIN_MASK(lcd->sclPin);
+		HAL_GPIO_Init(LCD_PIN_PORT(lcd->sclPin), &gpio);
+		gpio.Pin = LCD_PIN_MASK(lcd->sdaPin);
+		HAL_GPIO_Init(LCD_PIN_PORT(lcd->sdaPin), &gpio);
+
+		// a slave holding SDA low is in the middle of a byte, clocking it out (at most 9 clocks) makes it release the line
+		for (uint32_t i = 0; i < 9 && HAL_GPIO_ReadPin(LCD_PIN_PORT(lcd->sdaPin), LCD_PIN_MASK(lcd->sdaPin)) == GPIO_PIN_RESET; ++i) {
+			LCD_WRITE_PIN(lcd->sclPin, GPIO_PIN_RESET);
+			LCD_delayUs(I2C_HALF_PERIOD_US);
+			LCD_WRITE_PIN(lcd->sclPin, GPIO_PIN_SET);
+			LCD_delayUs(I2C_HALF_PERIOD_US);
+		}
+
+		// generate a STOP condition (SDA rises while SCL is high)
+		LCD_WRITE_PIN(lcd->sclPin, GPIO_PIN_RESET);
+		LCD_WRITE_PIN(lcd->sdaPin, GPIO_PIN_RESET);
+		LCD_delayUs(I2C_HALF_PERIOD_US);
+		LCD_WRITE_PIN(lcd->sclPin, GPIO_PIN_SET);
+		LCD_delayUs(I2C_HALF_PERIOD_US);
+		LCD_WRITE_PIN(lcd->sdaPin, GPIO_PIN_SET);
+		LCD_delayUs(I2C_HALF_PERIOD_US);
+	}
+
+	// hand the pins back to the peripheral (the MSP initialization configures them for I2C again)
+	HAL_I2C_Init(lcd->I2CHandle);
+}
+
+#if LCD_USE_LL
+/**
+ * @brief							Transmits a frame to the I2C Expander with the Low-Layer (LL) drivers, bypassing the locking and state checks of the HAL
+ *
+ * The error code of the I2C handle is set the same way the HAL sets it, so that failed frames are accounted for the same way. The peripheral counts at most
+ * 255 bytes at a time, so longer frames are sent in reload mode, 255 bytes at a time, within the same transfer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the frame
+ * @param		len					Length of the frame
+ * @param		timeout				Timeout of the transfer (in milliseconds)
+ *
+ * @return							HAL_OK if the frame was transmitted, HAL_ERROR if it was not acknowledged or the bus failed, HAL_TIMEOUT if it did not complete in time
+ */
+static HAL_StatusTypeDef LCD_masterTransmitLL(HD44780_LCD_t *lcd, const uint8_t *buf, uint16_t len, uint32_t timeout) {
+	I2C_TypeDef *I2Cx = lcd->I2CHandle->Instance;
+	const uint32_t start = HAL_GetTick();
+	HAL_StatusTypeDef status = HAL_OK;
+
+	// number of bytes not yet handed to the byte counter of the peripheral
+	uint32_t pending = (len > I2C_MAX_NBYTES) ? (len - I2C_MAX_NBYTES) : (0);
+
+	lcd->I2CHandle->ErrorCode = HAL_I2C_ERROR_NONE;
+	LL_I2C_HandleTransfer(I2Cx, lcd->I2CAddr, LL_I2C_ADDRSLAVE_7BIT, len - pending,
+			(pending > 0) ? (LL_I2C_MODE_RELOAD) : (LL_I2C_MODE_AUTOEND), LL_I2C_GENERATE_START_WRITE);
+
+	// the STOP condition is generated automatically after the last byte, or after a NACK
+	while (!LL_I2C_IsActiveFlag_STOP(I2Cx)) {
+		if (LL_I2C_IsActiveFlag_TXIS(I2Cx) && len > 0) {
+			LL_I2C_TransmitData8(I2Cx, *buf++);
+			--len;
+		}
+		if (LL_I2C_IsActiveFlag_TCR(I2Cx) && pending > 0) {
+			// the last part of the frame leaves reload mode so that the STOP condition is generated after it (writing the count clears TCR)
+			const uint32_t count = (pending > I2C_MAX_NBYTES) ? (I2C_MAX_NBYTES) : (pending);
+			if (count == pending) {
+				LL_I2C_DisableReloadMode(I2Cx);
+				LL_I2C_EnableAutoEndMode(I2Cx);
+			}
+			LL_I2C_SetTransferSize(I2Cx, count);
+			pending -= count;
+		}
+		if (LL_I2C_IsActiveFlag_BERR(I2Cx) || LL_I2C_IsActiveFlag_ARLO(I2Cx)) {
+			lcd->I2CHandle->ErrorCode |= (LL_I2C_IsActiveFlag_BERR(I2Cx)) ? (HAL_I2C_ERROR_BERR) : (HAL_I2C_ERROR_ARLO);
+			LL_I2C_ClearFlag_BERR(I2Cx);
+			LL_I2C_ClearFlag_ARLO(I2Cx);
+			status = HAL_ERROR;
+			break;
+		}
+		if (HAL_GetTick() - start > timeout) {
+			lcd->I2CHandle->ErrorCode |= HAL_I2C_ERROR_TIMEOUT;
+			status = HAL_TIMEOUT;
+			break;
+		}
+	}
+
+	if (LL_I2C_IsActiveFlag_NACK(I2Cx)) {
+		lcd->I2CHandle->ErrorCode |= HAL_I2C_ERROR_AF;
+		LL_I2C_ClearFlag_NACK(I2Cx);
+		status = HAL_ERROR;
+	}
+
+	// a byte left in the transmit register by a failed transfer is flushed, and the transfer settings are cleared
+	LL_I2C_ClearFlag_TXE(I2Cx);
+	LL_I2C_ClearFlag_STOP(I2Cx);
+	I2Cx->CR2 &= ~(I2C_CR2_SADD | I2C_CR2_HEAD10R | I2C_CR2_NBYTES | I2C_CR2_RELOAD | I2C_CR2_RD_WRN);
+
+	return status;
+}
+#endif
+
+/**
+ * @brief							Checks whether a device acknowledges its address on the I2C bus, without waiting for a busy bus to become free
+ *
+ * @param		I2CHandle			Pointer to structure to the I2C interface to probe
+ * @param		addr				Address of the device on the I2C bus
+ *
+ * @return							HAL_OK if the device acknowledged its address
+ */
+static HAL_StatusTypeDef LCD_pingI2C(I2C_HandleTypeDef *I2CHandle, uint8_t addr) {
+	if (__HAL_I2C_GET_FLAG(I2CHandle, I2C_FLAG_BUSY)) {
+		return HAL_BUSY;
+	}
+	return HAL_I2C_IsDeviceReady(I2CHandle, addr, 1, LCD_I2C_TIMEOUT(0));
+}
+
+/**
+ * @brief							Returns the address of the I2C Expander probed at the given position of the search order
+ *
+ * @param		index				Position in the search order (0 to PROBE_ADDR_COUNT-1)
+ *
+ * @return							Address of the I2C Expander (PC8574 addresses first, PC8574A addresses after)
+ */
+static uint8_t LCD_probeAddr(uint32_t index) {
+	return (index < 8) ? (PCF8574_BASE_ADDR + (index << 1)) : (PCF8574A_BASE_ADDR + ((index - 8) << 1));
+}
+
+/**
+ * @brief							Probes for the I2C Expander of an offline LCD (if the LCD was created by searching, a single address of the search is probed per call)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_OK if the I2C Expander was found, in which case its address is bound to the LCD
+ */
+static HAL_StatusTypeDef LCD_probeI2CStep(HD44780_LCD_t *lcd) {
+	if (lcd->I2CProbeOrdinal == PROBE_FIXED) {
+		return LCD_pingI2C(lcd->I2CHandle, lcd->I2CAddr);
+	}
+
+	const uint8_t addr = LCD_probeAddr(lcd->I2CProbeIndex);
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	if (LCD_pingI2C(lcd->I2CHandle, addr) == HAL_OK && lcd->I2CProbeFound++ == lcd->I2CProbeOrdinal) {
+		lcd->I2CAddr = addr;
+		status = HAL_OK;
+	}
+
+	if (status == HAL_OK || ++lcd->I2CProbeIndex == PROBE_ADDR_COUNT) {
+		lcd->I2CProbeIndex = 0;
+		lcd->I2CProbeFound = 0;
+	}
+
+	return status;
+}
+
+#endif
+
+/**
+ * @brief							Sends a byte of information to the LCD through its transport, without affecting its shadow buffer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		value				Byte of information to send
+ * @param		isData				Whether the byte is an instruction (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeRaw(HD44780_LCD_t *lcd, uint8_t value, uint8_t isData) {
+	return lcd->transport->write(lcd, &value, 1, isData);
+}
+
+/**
+ * @brief							Returns how long the LCD takes to execute a byte beyond what the transport waits for, which is only non-zero for clearing the display or returning home
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		value				Byte of information that was sent
+ * @param		isData				Whether the byte was an instruction (0) or Data (1)
+ *
+ * @return							Number of microseconds to wait before the next transfer
+ */
+static uint32_t LCD_execUs(const HD44780_LCD_t *lcd, uint8_t value, uint8_t isData) {
+	if (!isData && value != 0 && (value & ~(LCD_CLEAR_DISPLAY | LCD_SET_CURSOR_HOME)) == 0) {
+		return lcd->variant->clearUs;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief							Waits for the LCD to clear the display or return home, which take longer than the transport waits for (the execution time of every other byte is covered by the transport)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		value				Byte of information that was sent
+ * @param		isData				Whether the byte was an instruction (0) or Data (1)
+ */
+static void LCD_waitExec(HD44780_LCD_t *lcd, uint8_t value, uint8_t isData) {
+	const uint32_t us = LCD_execUs(lcd, value, isData);
+
+	if (us != 0) {
+		LCD_delayUs(us);
+	}
+}
+
+/**
+ * @brief							Returns the width of the bus to the controller of the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							LCD_BUS_SIZE_4 or LCD_BUS_SIZE_8
+ */
+static uint8_t LCD_busSize(const HD44780_LCD_t *lcd) {
+	return lcd->transport->busSize;
+}
+
+/**
+ * @brief							Returns the function set instruction of the LCD (2 lines of 5x8 characters, along with the bus size and the flags of the variant)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Function set instruction
+ */
+static uint8_t LCD_functionSet(const HD44780_LCD_t *lcd) {
+	return LCD_SET_FUNCTION | LCD_busSize(lcd) | LCD_DOT_COUNT_8 | LCD_LINE_COUNT_2 | lcd->functionFlags;
+}
+
+/**
+ * @brief							Sends an entry of a sequence of instructions and data, and waits for it to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		entry				Entry of the sequence (flagged with LCD_SEQ_DATA or LCD_SEQ_FUNCTION)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeEntry(HD44780_LCD_t *lcd, uint16_t entry) {
+	const uint8_t isData = (entry & LCD_SEQ_DATA) ? (1) : (0);
+	const uint8_t value = (entry & 0xFF) | ((entry & LCD_SEQ_FUNCTION) ? (LCD_busSize(lcd)) : (0));
+
+	const HAL_StatusTypeDef status = LCD_writeRaw(lcd, value, isData);
+	if (status == HAL_OK) {
+		LCD_waitExec(lcd, value, isData);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends a sequence of instructions and data followed by the function set of the LCD, without affecting its shadow buffer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		seq					Pointer to the sequence
+ * @param		len					Number of entries in the sequence
+ *
+ * @return							Status of the transfers to the LCD (the sequence stops at the first entry that fails)
+ */
+static HAL_StatusTypeDef LCD_writeSequence(HD44780_LCD_t *lcd, const uint16_t *seq, uint32_t len) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		status = LCD_writeEntry(lcd, seq[i]);
+	}
+	if (status == HAL_OK) {
+		status = LCD_writeEntry(lcd, LCD_functionSet(lcd));
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends the contrast sequence of the variant of the controller with the contrast of the LCD, followed by the function set of the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfers to the LCD (the sequence stops at the first entry that fails)
+ */
+static HAL_StatusTypeDef LCD_writeContrast(HD44780_LCD_t *lcd) {
+	const HD44780_LCD_Variant_t *variant = lcd->variant;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint32_t i = 0; i < variant->contrastLen && status == HAL_OK; ++i) {
+		status = LCD_writeEntry(lcd, (i == variant->contrastPos) ? (lcd->contrast) : (variant->contrast[i]));
+	}
+	if (status == HAL_OK) {
+		status = LCD_writeEntry(lcd, LCD_functionSet(lcd));
+	}
+
+	return status;
+}
+
+#if LCD_USE_GPIO
+/**
+ * @brief							Sends the higher nibble of an instruction to the LCD via GPIO Pins in 4-bit mode
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction whose higher nibble is sent
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeInitHalfBus(HD44780_LCD_t *lcd, uint8_t instruction) {
+	LCD_WRITE_PIN(lcd->rsPin, GPIO_PIN_RESET);
+	return LCD_sendNibble(lcd, HI_NIBBLE(instruction));
+}
+
+/**
+ * @brief							Sends a sequence of bytes to the LCD via GPIO Pins in 4-bit mode, waiting for each byte to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeHalfBus(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	LCD_WRITE_PIN(lcd->rsPin, (isData) ? (GPIO_PIN_SET) : (GPIO_PIN_RESET));
+
+	for (uint32_t i = 0; i < len; ++i) {
+		LCD_sendNibble(lcd, HI_NIBBLE(buf[i]));
+		LCD_sendNibble(lcd, LO_NIBBLE(buf[i]));
+		LCD_delayUs(lcd->variant->execUs);
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Sends an instruction to the LCD via GPIO Pins in 8-bit mode
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeInitFullBus(HD44780_LCD_t *lcd, uint8_t instruction) {
+	LCD_WRITE_PIN(lcd->rsPin, GPIO_PIN_RESET);
+	return LCD_sendByte(lcd, instruction);
+}
+
+/**
+ * @brief							Sends a sequence of bytes to the LCD via GPIO Pins in 8-bit mode, waiting for each byte to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeFullBus(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	LCD_WRITE_PIN(lcd->rsPin, (isData) ? (GPIO_PIN_SET) : (GPIO_PIN_RESET));
+
+	for (uint32_t i = 0; i < len; ++i) {
+		LCD_sendByte(lcd, buf[i]);
+		LCD_delayUs(lcd->variant->execUs);
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Sends an instruction to the LCD via a shift register
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeInitShiftRegister(HD44780_LCD_t *lcd, uint8_t instruction) {
+	LCD_WRITE_PIN(lcd->rsPin, GPIO_PIN_RESET);
+	return LCD_shiftByte(lcd, instruction);
+}
+
+/**
+ * @brief							Sends a sequence of bytes to the LCD via a shift register, waiting for each byte to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+static HAL_StatusTypeDef LCD_writeShiftRegister(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	LCD_WRITE_PIN(lcd->rsPin, (isData) ? (GPIO_PIN_SET) : (GPIO_PIN_RESET));
+
+	for (uint32_t i = 0; i < len; ++i) {
+		LCD_shiftByte(lcd, buf[i]);
+		LCD_delayUs(lcd->variant->execUs);
+	}
+
+	return HAL_OK;
+}
+
+#endif
+
+/**
+ * @brief							Initializes the fields of an LCD structure that are common to every transport
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		busMode				How the LCD is driven
+ * @param		transport			Pointer to the transport of the LCD
+ */
+static void LCD_createCommon(HD44780_LCD_t *lcd, enum HD44780_LCD_BUS_MODE busMode, const HD44780_LCD_Transport_t *transport) {
+	lcd->busMode = busMode;
+	lcd->transport = transport;
+	lcd->transportContext = NULL;
+	LCD_setVariant(lcd, &LCD_VARIANT_HD44780);
+
+	// the fields of the transport share storage, so only the create function of the transport initializes them
+	lcd->backlight = 0;
+
+	// only LCDs driven via I2C can go offline
+	lcd->I2CLink = linkOnline;
+}
+
+#if LCD_USE_I2C
+/**
+ * @brief							Sends the higher nibble of an instruction to the LCD via a PC8574 Expander
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction whose higher nibble is sent
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitPCF8574(HD44780_LCD_t *lcd, uint8_t instruction) {
+	return LCD_sendNibbleI2C(lcd, HI_NIBBLE(instruction), 0);
+}
+
+/**
+ * @brief							Sends a sequence of bytes to the LCD via a PC8574 Expander, one nibble per transfer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first nibble that fails)
+ */
+static HAL_StatusTypeDef LCD_writePCF8574(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	// the second nibble is not sent if the first failed, as the LCD would otherwise lose track of nibble order
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		status = LCD_sendNibbleI2C(lcd, HI_NIBBLE(buf[i]), isData);
+		if (status == HAL_OK) {
+			status = LCD_sendNibbleI2C(lcd, LO_NIBBLE(buf[i]), isData);
+		}
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Updates the state of the backlight driven by a PC8574 Expander
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeBacklightPCF8574(HD44780_LCD_t *lcd) {
+	LCD_encodeI2CNibbles(lcd);
+	return LCD_transmitI2C(lcd, (uint8_t *)&(lcd->backlightMask), 1);
+}
+
+/**
+ * @brief							Accounts for a byte that could not be sent because the LCD is not online (it is kept in the shadow buffer and replayed once the LCD is re-attached)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_ERROR
+ */
+static HAL_StatusTypeDef LCD_deferI2C(HD44780_LCD_t *lcd) {
+	++lcd->I2CStats.dropped;
+	lcd->I2CReplayDirty = 1;
+
+	return HAL_ERROR;
+}
+
+/**
+ * @brief							Sends the next byte of the shadow buffer to a re-attached LCD, after which its address counter, display shift and state are restored
+ *
+ * If the copy of the memories is compiled out (LCD_USE_SHADOW is 0), only the state is restored, and the LCD is left cleared
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_replayStep(HD44780_LCD_t *lcd) {
+	const HD44780_LCD_Shadow_t *shadow = &(lcd->shadow);
+	uint32_t pos = lcd->I2CReplayPos++;
+
+	// each range of positions below corresponds to one part of the replay, in the order they are sent
+	if (pos == 0) {
+		return LCD_writeRaw(lcd, LCD_SET_ENTRY_MODE | LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC, 0);
+	}
+	pos -= 1;
+#if LCD_USE_SHADOW
+	if (pos == 0) {
+		return LCD_writeRaw(lcd, LCD_SET_CGRAMADDR, 0);
+	}
+	pos -= 1;
+	if (pos < LCD_CGRAM_SIZE) {
+		return LCD_writeRaw(lcd, shadow->cgram[pos], 1);
+	}
+	pos -= LCD_CGRAM_SIZE;
+	for (uint32_t row = 0; row < 2; ++row) {
+		if (pos == 0) {
+			return LCD_writeRaw(lcd, LCD_SET_DDRAMADDR | ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)), 0);
+		}
+		pos -= 1;
+		if (pos < LCD_LINE_SIZE) {
+			return LCD_writeRaw(lcd, shadow->ddram[row][pos], 1);
+		}
+		pos -= LCD_LINE_SIZE;
+	}
+#endif
+	if (pos < shadow->shift) {
+		return LCD_writeRaw(lcd, LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_LT, 0);
+	}
+	pos -= shadow->shift;
+	if (pos == 0) {
+		return LCD_writeRaw(lcd, LCD_CONTROL_DISPLAY | lcd->displayState, 0);
+	}
+	pos -= 1;
+	if (pos == 0) {
+		return LCD_writeRaw(lcd, LCD_SET_ENTRY_MODE | lcd->cursorMovement, 0);
+	}
+	pos -= 1;
+	if (pos == 0) {
+		return LCD_writeRaw(lcd, ((shadow->inCGRAM) ? (LCD_SET_CGRAMADDR) : (LCD_SET_DDRAMADDR)) | shadow->addr, 0);
+	}
+
+	// the replay is complete, unless bytes were written to the shadow buffer while it was in progress
+	if (lcd->I2CReplayDirty) {
+		lcd->I2CReplayDirty = 0;
+		lcd->I2CReplayPos = 0;
+	} else {
+		lcd->I2CFailures = 0;
+		lcd->I2CLink = linkOnline;
+	}
+	return HAL_OK;
+}
+
+#endif
+
+/**
+ * @brief							Resets the shadow buffer to the state of the LCD after it has been initialized
+ *
+ * @param		lcd					Pointer to LCD structure
+ */
+static void LCD_resetShadow(HD44780_LCD_t *lcd) {
+#if LCD_USE_SHADOW
+	for (uint32_t i = 0; i < LCD_CGRAM_SIZE; ++i) {
+		lcd->shadow.cgram[i] = 0;
+	}
+	for (uint32_t i = 0; i < LCD_LINE_SIZE; ++i) {
+		lcd->shadow.ddram[0][i] = ' ';
+		lcd->shadow.ddram[1][i] = ' ';
+	}
+#endif
+
+	lcd->shadow.addr = 0;
+	lcd->shadow.inCGRAM = 0;
+	lcd->shadow.shift = 0;
+}
+
+/**
+ * @brief							Moves the address counter of the shadow buffer by one position, the same way the LCD does
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		increment			Whether the address counter is incremented (1) or decremented (0)
+ */
+static void LCD_stepShadowAddr(HD44780_LCD_t *lcd, uint32_t increment) {
+	HD44780_LCD_Shadow_t *shadow = &(lcd->shadow);
+
+	if (shadow->inCGRAM) {
+		shadow->addr = (shadow->addr + ((increment) ? (1) : (-1))) & CGRAM_ADDR_MASK;
+	} else if (increment) {
+		// in two-line mode, the end of the first line wraps to the start of the second and vice-versa
+		shadow->addr = (shadow->addr == LCD_ORIG_ADDR_FIRST + LCD_LINE_SIZE - 1) ? (LCD_ORIG_ADDR_SECOND)
+				: (shadow->addr == LCD_ORIG_ADDR_SECOND + LCD_LINE_SIZE - 1) ? (LCD_ORIG_ADDR_FIRST)
+				: (shadow->addr + 1);
+	} else {
+		shadow->addr = (shadow->addr == LCD_ORIG_ADDR_FIRST) ? (LCD_ORIG_ADDR_SECOND + LCD_LINE_SIZE - 1)
+				: (shadow->addr == LCD_ORIG_ADDR_SECOND) ? (LCD_ORIG_ADDR_FIRST + LCD_LINE_SIZE - 1)
+				: (shadow->addr - 1);
+	}
+}
+
+/**
+ * @brief							Applies the effect of an instruction sent to the LCD to its shadow buffer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction with parameter bitmask
+ */
+static void LCD_trackInstruction(HD44780_LCD_t *lcd, uint8_t instruction) {
+	HD44780_LCD_Shadow_t *shadow = &(lcd->shadow);
+
+	// the instruction is identified by its most significant set bit
+	if (instruction & LCD_SET_DDRAMADDR) {
+		shadow->addr = instruction & DDRAM_ADDR_MASK;
+		shadow->inCGRAM = 0;
+	} else if (instruction & LCD_SET_CGRAMADDR) {
+		shadow->addr = instruction & CGRAM_ADDR_MASK;
+		shadow->inCGRAM = 1;
+	} else if (instruction & LCD_SET_FUNCTION) {
+		// the function does not change the contents of the LCD
+	} else if (instruction & LCD_SHIFT_CURSOR) {
+		if ((instruction & LCD_DISPLAY_MOVE_LT) == 0) {
+			LCD_stepShadowAddr(lcd, instruction & LCD_CURSOR_MOVE_RT);
+		} else if (instruction & LCD_CURSOR_MOVE_RT) {
+			shadow->shift = (shadow->shift + LCD_LINE_SIZE - 1) % LCD_LINE_SIZE;
+		} else {
+			shadow->shift = (shadow->shift + 1) % LCD_LINE_SIZE;
+		}
+	} else if (instruction & LCD_CONTROL_DISPLAY) {
+		lcd->displayState = instruction & (LCD_DISPLAY_ENABLE | LCD_CURSOR_ENABLE | LCD_BLINK_ENABLE);
+	} else if (instruction & LCD_SET_ENTRY_MODE) {
+		lcd->cursorMovement = instruction & (LCD_DISPLAY_MOVE | LCD_CURSOR_POS_INC);
+	} else if (instruction & LCD_SET_CURSOR_HOME) {
+		shadow->addr = 0;
+		shadow->inCGRAM = 0;
+		shadow->shift = 0;
+	} else if (instruction & LCD_CLEAR_DISPLAY) {
+#if LCD_USE_SHADOW
+		for (uint32_t i = 0; i < LCD_LINE_SIZE; ++i) {
+			shadow->ddram[0][i] = ' ';
+			shadow->ddram[1][i] = ' ';
+		}
+#endif
+		shadow->addr = 0;
+		shadow->inCGRAM = 0;
+		shadow->shift = 0;
+		lcd->cursorMovement |= LCD_CURSOR_POS_INC;
+	}
+}
+
+/**
+ * @brief							Applies the effect of a byte of data sent to the LCD to its shadow buffer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		data				Data sent to the LCD
+ */
+static void LCD_trackData(HD44780_LCD_t *lcd, uint8_t data) {
+	HD44780_LCD_Shadow_t *shadow = &(lcd->shadow);
+	const uint32_t increment = lcd->cursorMovement & LCD_CURSOR_POS_INC;
+
+#if LCD_USE_SHADOW
+	if (shadow->inCGRAM) {
+		shadow->cgram[shadow->addr] = data;
+	} else if ((shadow->addr & ~LCD_ORIG_ADDR_SECOND) < LCD_LINE_SIZE) {
+		shadow->ddram[(shadow->addr & LCD_ORIG_ADDR_SECOND) ? 1 : 0][shadow->addr & ~LCD_ORIG_ADDR_SECOND] = data;
+	}
+#else
+	(void) data;
+#endif
+
+	LCD_stepShadowAddr(lcd, increment);
+
+	// when the display moves instead of the cursor, it shifts left while incrementing and right while decrementing
+	if (!shadow->inCGRAM && (lcd->cursorMovement & LCD_DISPLAY_MOVE)) {
+		shadow->shift = (increment) ? ((shadow->shift + 1) % LCD_LINE_SIZE) : ((shadow->shift + LCD_LINE_SIZE - 1) % LCD_LINE_SIZE);
+	}
+}
+
+/** Transports ---------------------------------------------------------------*/
+
+#if LCD_USE_GPIO
+// GPIO Pins driving the LCD in 4-bit mode
+const HD44780_LCD_Transport_t LCD_GPIO_HALF_BUS = {
+	.busSize = LCD_BUS_SIZE_4,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitHalfBus,
+	.write = LCD_writeHalfBus,
+	.writeBacklight = LCD_writeBacklightNone
+};
+
+// GPIO Pins driving the LCD in 8-bit mode
+const HD44780_LCD_Transport_t LCD_GPIO_FULL_BUS = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitFullBus,
+	.write = LCD_writeFullBus,
+	.writeBacklight = LCD_writeBacklightNone
+};
+
+// 74HC595 Shift Register driving the LCD in 8-bit mode (RS and EN are driven by GPIO Pins)
+const HD44780_LCD_Transport_t LCD_SHIFT_REGISTER = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitShiftRegister,
+	.write = LCD_writeShiftRegister,
+	.writeBacklight = LCD_writeBacklightNone
+};
+#endif
+
+#if LCD_USE_I2C
+// PC8574 Expander, which drives the LCD in 4-bit mode (by default, with the data on P4-P7 and the control lines on the pins given by RS_ID, EN_ID and BACKLIGHT_ID)
+const HD44780_LCD_Transport_t LCD_PCF8574 = {
+	.busSize = LCD_BUS_SIZE_4,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitPCF8574,
+	.write = LCD_writePCF8574,
+	.writeBacklight = LCD_writeBacklightPCF8574
+};
+#endif
+
+/** Functions ----------------------------------------------------------------*/
+
+#if LCD_USE_GPIO
+/**
+ * @brief							Initializes an LCD structure to operate the HD44780 controller in 4-bit mode
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		port0				GPIO Port on which pin D4 of the LCD is connected
+ * @param		pin0				GPIO Pin number within the port to which pin D4 of the LCD is connected
+ * @param		port1				GPIO Port on which pin D5 of the LCD is connected
+ * @param		pin1				GPIO Pin number within the port to which pin D5 of the LCD is connected
+ * @param		port2				GPIO Port on which pin D6 of the LCD is connected
+ * @param		pin2				GPIO Pin number within the port to which pin D6 of the LCD is connected
+ * @param		port3				GPIO Port on which pin D7 of the LCD is connected
+ * @param		pin3				GPIO Pin number within the port to which pin D7 of the LCD is connected
+ * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
+ * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
+ * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
+ * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ */
+void LCD_createHalfBus(HD44780_LCD_t *lcd, GPIO_TypeDef *port0, uint16_t pin0,
+		GPIO_TypeDef *port1, uint16_t pin1, GPIO_TypeDef *port2, uint16_t pin2,
+		GPIO_TypeDef *port3, uint16_t pin3, GPIO_TypeDef *enPort,
+		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
+	LCD_createCommon(lcd, halfBus, &LCD_GPIO_HALF_BUS);
+
+	lcd->dataPins[0] = LCD_encodePin(port0, pin0);
+	lcd->dataPins[1] = LCD_encodePin(port1, pin1);
+	lcd->dataPins[2] = LCD_encodePin(port2, pin2);
+	lcd->dataPins[3] = LCD_encodePin(port3, pin3);
+
+	lcd->enPin = LCD_encodePin(enPort, enPin);
+	lcd->rsPin = LCD_encodePin(rsPort, rsPin);
+}
+
+/**
+ * @brief							Initializes an LCD structure to operate the HD44780 controller in 4-bit mode
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		port0				GPIO Port on which pin D0 of the LCD is connected
+ * @param		pin0				GPIO Pin number within the port to which pin D0 of the LCD is connected
+ * @param		port1				GPIO Port on which pin D1 of the LCD is connected
+ * @param		pin1				GPIO Pin number within the port to which pin D1 of the LCD is connected
+ * @param		port2				GPIO Port on which pin D2 of the LCD is connected
+ * @param		pin2				GPIO Pin number within the port to which pin D2 of the LCD is connected
+ * @param		port3				GPIO Port on which pin D3 of the LCD is connected
+ * @param		pin3				GPIO Pin number within the port to which pin D3 of the LCD is connected\
+ * @param		port4				GPIO Port on which pin D4 of the LCD is connected
+ * @param		pin4				GPIO Pin number within the port to which pin D4 of the LCD is connected
+ * @param		port5				GPIO Port on which pin D5 of the LCD is connected
+ * @param		pin5				GPIO Pin number within the port to which pin D5 of the LCD is connected
+ * @param		port6				GPIO Port on which pin D6 of the LCD is connected
+ * @param		pin6				GPIO Pin number within the port to which pin D6 of the LCD is connected
+ * @param		port7				GPIO Port on which pin D7 of the LCD is connected
+ * @param		pin7				GPIO Pin number within the port to which pin D7 of the LCD is connected
+ * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
+ * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
+ * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
+ * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ */
+void LCD_createFullBus(HD44780_LCD_t *lcd, GPIO_TypeDef *port0, uint16_t pin0,
+		GPIO_TypeDef *port1, uint16_t pin1, GPIO_TypeDef *port2, uint16_t pin2,
+		GPIO_TypeDef *port3, uint16_t pin3, GPIO_TypeDef *port4, uint16_t pin4,
+		GPIO_TypeDef *port5, uint16_t pin5, GPIO_TypeDef *port6, uint16_t pin6,
+		GPIO_TypeDef *port7, uint16_t pin7, GPIO_TypeDef *enPort,
+		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
+	LCD_createCommon(lcd, fullBus, &LCD_GPIO_FULL_BUS);
+
+	lcd->dataPins[0] = LCD_encodePin(port0, pin0);
+	lcd->dataPins[1] = LCD_encodePin(port1, pin1);
+	lcd->dataPins[2] = LCD_encodePin(port2, pin2);
+	lcd->dataPins[3] = LCD_encodePin(port3, pin3);
+	lcd->dataPins[4] = LCD_encodePin(port4, pin4);
+	lcd->dataPins[5] = LCD_encodePin(port5, pin5);
+	lcd->dataPins[6] = LCD_encodePin(port6, pin6);
+	lcd->dataPins[7] = LCD_encodePin(port7, pin7);
+
+	lcd->enPin = LCD_encodePin(enPort, enPin);
+	lcd->rsPin = LCD_encodePin(rsPort, rsPin);
+}
+
+/**
+ * @brief							Initializes the LCD to be used along with a 74HC595 Shift Register
+ *
+ * The Shift Register is used to operate the LCD in 8-bit mode, and the wiring should be done in reverse order, i.e.
+ * Shift Register O0 is wired to LCD D7, O1 to D6 etc.
+ * he RS and En pins are not operated by the Shift Register and must be directly wired to the microcontroller
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		dataPort			GPIO Port on which the Data-In pin of the Shift Register is connected
+ * @param		dataPin				GPIO Pin within the Port to which the Data-In pin of the Shift Register is connected
+ * @param		clockPort			GPIO Port on which the Clock-In pin of the Shift Register is connected
+ * @param		clockPin			GPIO Pin within the Port to which the Clock-In pin of the Shift Register is connected
+ * @param		latchPort			GPIO Port on which the Output-Latch pin of the Shift Register is connected
+ * @param		latchPin			GPIO Pin within the Port to which the Output-Latch pin of the Shift Register is connected
+ * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
+ * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
+ * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
+ * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ */
+void LCD_createShiftRegister(HD44780_LCD_t *lcd, GPIO_TypeDef *dataPort,
+		uint16_t dataPin, GPIO_TypeDef *clockPort, uint16_t clockPin,
+		GPIO_TypeDef *latchPort, uint16_t latchPin, GPIO_TypeDef *enPort,
+		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
+	LCD_createCommon(lcd, shiftReg, &LCD_SHIFT_REGISTER);
 
-// Alias to refer to the GPIO Port used to connect to the Data pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   DATA_PORT          	dataPort[0]
-// Alias to refer to the GPIO Port used to connect to the Clock pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   CLOCK_PORT          	dataPort[1]
-// Alias to refer to the GPIO Port used to connect to the Latch pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   LATCH_PORT          	dataPort[2]
+	lcd->DATA_PIN = LCD_encodePin(dataPort, dataPin);
+	lcd->CLOCK_PIN = LCD_encodePin(clockPort, clockPin);
+	lcd->LATCH_PIN = LCD_encodePin(latchPort, latchPin);
 
-// Alias to refer to the GPIO Pin used to connect to the Data pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   DATA_PIN          	dataPin[0]
-// Alias to refer to the GPIO Pin used to connect to the Clock pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   CLOCK_PIN          	dataPin[1]
-// Alias to refer to the GPIO Pin used to connect to the Latch pin of the Shift Register (this is used when the LCD is operated by the shift register)
-#define   LATCH_PIN          	dataPin[2]
+	lcd->enPin = LCD_encodePin(enPort, enPin);
+	lcd->rsPin = LCD_encodePin(rsPort, rsPin);
+}
+#endif
 
-/** Functions ----------------------------------------------------------------*/
+/**
+ * @brief							Initializes the LCD to be driven by a user-defined transport, e.g. a different I2C IO Expander, a parallel bus or a DMA-driven interface
+ *
+ * The transport can use the context to find its own state. LCD_sendInstruction, LCD_sendData and LCD_sendBuffer call into the transport without
+ * checking how the LCD is driven, so an LCD created this way is used like any other
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		transport			Pointer to the transport (must remain valid while the LCD is used)
+ * @param		context				Pointer to the state of the transport (stored in transportContext, can be NULL)
+ */
+void LCD_createTransport(HD44780_LCD_t *lcd, const HD44780_LCD_Transport_t *transport, void *context) {
+	LCD_createCommon(lcd, custom, transport);
+	lcd->transportContext = context;
+}
 
 /**
- * @brief							Initializes an LCD structure to operate the HD44780 controller in 4-bit mode
+ * @brief							Checks whether the LCD is online, i.e. information sent to it reaches the display (LCDs driven via GPIO Pins are always online)
  *
  * @param		lcd					Pointer to LCD structure
- * @param		port0				GPIO Port on which pin D4 of the LCD is connected
- * @param		pin0				GPIO Pin number within the port to which pin D4 of the LCD is connected
- * @param		port1				GPIO Port on which pin D5 of the LCD is connected
- * @param		pin1				GPIO Pin number within the port to which pin D5 of the LCD is connected
- * @param		port2				GPIO Port on which pin D6 of the LCD is connected
- * @param		pin2				GPIO Pin number within the port to which pin D6 of the LCD is connected
- * @param		port3				GPIO Port on which pin D7 of the LCD is connected
- * @param		pin3				GPIO Pin number within the port to which pin D7 of the LCD is connected
- * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
- * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
- * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
- * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ *
+ * @return							1 if the LCD is online, 0 otherwise
  */
-void LCD_createHalfBus(HD44780_LCD_t *lcd, GPIO_TypeDef *port0, uint16_t pin0,
-		GPIO_TypeDef *port1, uint16_t pin1, GPIO_TypeDef *port2, uint16_t pin2,
-		GPIO_TypeDef *port3, uint16_t pin3, GPIO_TypeDef *enPort,
-		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
-	lcd->busMode = halfBus;
+uint8_t LCD_isOnline(const HD44780_LCD_t *lcd) {
+	return lcd->I2CLink == linkOnline;
+}
+
+#if LCD_USE_I2C
+/**
+ * @brief							Initializes the LCD to be used along with a PC8574 Driver controlled via I2C at address 0x27
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ */
+void LCD_createI2C(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle) {
+	LCD_createI2C_addr(lcd, I2CHandle, DEFAULT_I2C_ADDR);
+}
+
+/**
+ * @brief							Initializes the LCD to be used along with a PC8574 or PC8574A Driver controlled via I2C, whose address is found by probing the bus
+ *
+ * The PC8574 addresses (0x20 to 0x27) are probed before the PC8574A addresses (0x38 to 0x3F). If no Driver responds, the LCD is created offline and
+ * LCD_serviceI2C keeps searching for it
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		ordinal				Which of the responding Drivers to bind to (0 for the first)
+ *
+ * @return							HAL_OK if a Driver was found, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_createI2C_probe(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t ordinal) {
+	uint8_t lcdAddr = DEFAULT_I2C_ADDR;
+	const HAL_StatusTypeDef status = LCD_probeI2C(I2CHandle, ordinal, &lcdAddr);
+
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+	lcd->I2CProbeOrdinal = ordinal;
+
+	if (status != HAL_OK) {
+		lcd->I2CLink = linkOffline;
+		lcd->I2CLinkTick = HAL_GetTick();
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Searches the I2C bus for PC8574 (0x20 to 0x27) and PC8574A (0x38 to 0x3F) Drivers, in that order
+ *
+ * @param		I2CHandle			Pointer to structure to the I2C interface to search
+ * @param		ordinal				Which of the responding Drivers to return (0 for the first)
+ * @param		lcdAddr				Pointer to where the address of the Driver is stored (left unchanged if no Driver was found)
+ *
+ * @return							HAL_OK if a Driver was found, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_probeI2C(I2C_HandleTypeDef *I2CHandle, uint8_t ordinal, uint8_t *lcdAddr) {
+	for (uint32_t i = 0; i < PROBE_ADDR_COUNT; ++i) {
+		const uint8_t addr = LCD_probeAddr(i);
+
+		if (LCD_pingI2C(I2CHandle, addr) == HAL_OK && ordinal-- == 0) {
+			*lcdAddr = addr;
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+ * @brief							Initializes the LCD to be used along with a PC8574 Driver controlled via I2C
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the module on the I2C bus
+ *
+ */
+void LCD_createI2C_addr(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr) {
+	static const HD44780_LCD_ExpanderPins_t defaultPins = {
+		.rs = RS_ID, .en = EN_ID, .backlight = BACKLIGHT_ID, .data = {4, 5, 6, 7}
+	};
+
+	LCD_createCommon(lcd, I2C, &LCD_PCF8574);
+
+	lcd->I2CHandle = I2CHandle;
+	lcd->I2CAddr = lcdAddr;
+	LCD_setI2CPins(lcd, &defaultPins);
+
+	lcd->sclPin.port = LCD_PORT_NONE;
+	lcd->sdaPin.port = LCD_PORT_NONE;
+
+	lcd->I2CRetries = LCD_I2C_DEFAULT_RETRIES;
+	lcd->I2CFailures = 0;
+	LCD_resetI2CStats(lcd);
+
+	lcd->I2CProbeOrdinal = PROBE_FIXED;
+	lcd->I2CProbeIndex = 0;
+	lcd->I2CProbeFound = 0;
+}
+
+/**
+ * @brief							Initializes the LCD to be used along with a PC8574 Driver controlled via I2C, whose pins are wired differently from the usual backpack
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the module on the I2C bus
+ * @param		pins				Pointer to the pin map of the Driver (indices of the bits of P0-P7)
+ */
+void LCD_createI2C_pins(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins) {
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+	LCD_setI2CPins(lcd, pins);
+}
+
+/**
+ * @brief							Sets the pin map of the I2C Expander and pre-encodes the values of its port for every nibble (only applicable when the LCD is driven via I2C)
+ *
+ * The backlight is turned on, and the new pin map takes effect with the next transfer to the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		pins				Pointer to the pin map of the Expander
+ */
+void LCD_setI2CPins(HD44780_LCD_t *lcd, const HD44780_LCD_ExpanderPins_t *pins) {
+	lcd->expanderPins = *pins;
+	lcd->backlight = 1;
+
+	LCD_encodeI2CNibbles(lcd);
+}
+
+/**
+ * @brief							Encodes the value of the port of the I2C Expander for a nibble, according to its pin map and the state of the backlight (EN is low)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		isData				Whether the Nibble is an instruction (0) or Data (1)
+ * @param		nibble				Nibble to encode (only the lower 4-bits are considered)
+ *
+ * @return							Value of the port of the I2C Expander
+ */
+uint8_t LCD_encodeI2CNibble(const HD44780_LCD_t *lcd, uint8_t isData, uint8_t nibble) {
+	const HD44780_LCD_ExpanderPins_t *pins = &(lcd->expanderPins);
+	uint8_t result = lcd->backlightMask;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		result |= ((nibble >> i) & 1) << pins->data[i];
+	}
+
+	return (isData) ? (result | (1 << pins->rs)) : (result);
+}
+
+/**
+ * @brief							Pre-encodes the value of the port of the I2C Expander for every nibble with RS low and high, according to its pin map and the state of the backlight (EN is low in every value)
+ *
+ * Transports driving an I2C Expander call this whenever the state of the backlight changes. If LCD_I2C_NIBBLE_TABLE is 0, only the mask of the backlight
+ * is updated, and each nibble is encoded as it is sent
+ *
+ * @param		lcd					Pointer to LCD structure
+ */
+void LCD_encodeI2CNibbles(HD44780_LCD_t *lcd) {
+	lcd->backlightMask = (lcd->backlight) ? (1 << lcd->expanderPins.backlight) : (0);
+
+#if LCD_I2C_NIBBLE_TABLE
+	for (uint32_t nibble = 0; nibble < 16; ++nibble) {
+		lcd->I2CNibbles[0][nibble] = LCD_encodeI2CNibble(lcd, 0, nibble);
+		lcd->I2CNibbles[1][nibble] = LCD_encodeI2CNibble(lcd, 1, nibble);
+	}
+#endif
+}
+
+/**
+ * @brief							Sets the pins of the I2C bus, which allows a stuck bus to be recovered by clocking it manually (only applicable when the LCD is driven via I2C)
+ *
+ * Without these pins, recovering the bus only re-initializes the I2C peripheral
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		sclPort				GPIO Port on which the SCL line of the I2C bus is connected
+ * @param		sclPin				GPIO Pin number within the port to which the SCL line of the I2C bus is connected
+ * @param		sdaPort				GPIO Port on which the SDA line of the I2C bus is connected
+ * @param		sdaPin				GPIO Pin number within the port to which the SDA line of the I2C bus is connected
+ */
+void LCD_setI2CRecoveryPins(HD44780_LCD_t *lcd, GPIO_TypeDef *sclPort,
+		uint16_t sclPin, GPIO_TypeDef *sdaPort, uint16_t sdaPin) {
+	lcd->sclPin = LCD_encodePin(sclPort, sclPin);
+	lcd->sdaPin = LCD_encodePin(sdaPort, sdaPin);
+}
+
+/**
+ * @brief							Sets the number of times a failed I2C transfer is re-attempted before it is reported as failed (only applicable when the LCD is driven via I2C)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		retries				Number of re-attempts (0 disables retrying)
+ */
+void LCD_setI2CRetries(HD44780_LCD_t *lcd, uint8_t retries) {
+	lcd->I2CRetries = retries;
+}
+
+/**
+ * @brief							Recovers the I2C bus and brings the LCD back online if the I2C Expander responds (only applicable when the LCD is driven via I2C)
+ *
+ * The contents of the LCD are not restored, and LCD_init must be called again if the LCD lost power
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_OK if the I2C Expander responded after the recovery, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_recoverI2C(HD44780_LCD_t *lcd) {
+	if (lcd->busMode != I2C) {
+		return HAL_ERROR;
+	}
+
+	LCD_clearI2CBus(lcd);
+
+	if (LCD_pingI2C(lcd->I2CHandle, lcd->I2CAddr) != HAL_OK) {
+		return HAL_ERROR;
+	}
+
+	lcd->I2CFailures = 0;
+	lcd->I2CLink = linkOnline;
+	return HAL_OK;
+}
+
+/**
+ * @brief							Returns the error counters of the I2C transfers made to the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Pointer to the error counters of the LCD
+ */
+const HD44780_LCD_I2CStats_t *LCD_getI2CStats(const HD44780_LCD_t *lcd) {
+	return &(lcd->I2CStats);
+}
+
+/**
+ * @brief							Resets the error counters of the I2C transfers made to the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ */
+void LCD_resetI2CStats(HD44780_LCD_t *lcd) {
+	lcd->I2CStats.nack = 0;
+	lcd->I2CStats.timeout = 0;
+	lcd->I2CStats.busError = 0;
+	lcd->I2CStats.retries = 0;
+	lcd->I2CStats.recoveries = 0;
+	lcd->I2CStats.dropped = 0;
+}
+
+/**
+ * @brief							Re-attaches an LCD driven via I2C that was marked offline, and must be called periodically (e.g. from the main loop)
+ *
+ * An offline LCD is probed every LCD_I2C_PROBE_INTERVAL milliseconds. Once it responds, it is initialized again and the shadow buffer is replayed to it,
+ * which restores its contents. Each call performs at most a few short transfers and never waits, so the re-attachment happens in the background
+ *
+ * @param		lcd					Pointer to LCD structure
+ */
+void LCD_serviceI2C(HD44780_LCD_t *lcd) {
+	const uint32_t elapsed = HAL_GetTick() - lcd->I2CLinkTick;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	if (lcd->busMode != I2C) {
+		return;
+	}
+
+	switch (lcd->I2CLink) {
+	case linkOnline:
+		return;
+	case linkOffline:
+		// a search probes one address per call, and waits for the interval only before starting over
+		if (lcd->I2CProbeIndex == 0 && elapsed < LCD_I2C_PROBE_INTERVAL) {
+			return;
+		}
+		if (LCD_probeI2CStep(lcd) != HAL_OK) {
+			if (lcd->I2CProbeIndex == 0) {
+				lcd->I2CLinkTick = HAL_GetTick();
+			}
+			return;
+		}
+		lcd->I2CReplayPos = 0;
+		lcd->I2CReplayDirty = 0;
+		lcd->I2CFailures = 0;
+		// Expanders with registers lose their configuration along with power, so they are configured again (which needs the link out of linkOffline,
+		// as frames are dropped in that state), and the power-up delay of the LCD is counted from then on
+		lcd->I2CLink = linkPowerUp;
+		status = lcd->transport->configure(lcd);
+		if (status != HAL_OK) {
+			break;
+		}
+		lcd->I2CLinkTick = HAL_GetTick();
+		return;
+	case linkPowerUp:
+		// the LCD needs time to power up after being plugged in, after which the initialization sequence of LCD_init is followed
+		if (elapsed < lcd->variant->powerUpMs) {
+			return;
+		}
+		status = lcd->transport->writeInit(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_8);
+		break;
+	case linkWake1:
+	case linkWake2:
+		if (elapsed < US_TO_TICKS(lcd->variant->wakeUs)) {
+			return;
+		}
+		status = lcd->transport->writeInit(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_8);
+		break;
+	case linkWake3:
+		if (elapsed < US_TO_TICKS(lcd->variant->wakeUs)) {
+			return;
+		}
+		// an Expander that drives all 8 data lines keeps the LCD in 8-bit mode
+		if (lcd->transport->busSize == LCD_BUS_SIZE_4) {
+			status = lcd->transport->writeInit(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_4);
+		}
+		break;
+	case linkConfigure:
+		if (elapsed < US_TO_TICKS(lcd->variant->execUs)) {
+			return;
+		}
+		status = LCD_writeRaw(lcd, LCD_functionSet(lcd), 0);
+		if (status == HAL_OK && lcd->variant->setupLen != 0) {
+			status = LCD_writeSequence(lcd, lcd->variant->setup, lcd->variant->setupLen);
+		}
+		if (status == HAL_OK && lcd->variant->contrastLen != 0) {
+			status = LCD_writeContrast(lcd);
+		}
+		if (status == HAL_OK) {
+			status = LCD_writeRaw(lcd, LCD_CLEAR_DISPLAY, 0);
+		}
+		break;
+	case linkClear:
+		if (elapsed < US_TO_TICKS(lcd->variant->clearUs)) {
+			return;
+		}
+		break;
+	case linkReplay:
+		for (uint32_t i = 0; i < LCD_I2C_REPLAY_CHUNK && status == HAL_OK && lcd->I2CLink == linkReplay; ++i) {
+			status = LCD_replayStep(lcd);
+		}
+		if (status != HAL_OK) {
+			break;
+		}
+		return;
+	}
+
+	if (status != HAL_OK) {
+		lcd->I2CLink = linkOffline;
+	} else {
+		lcd->I2CLink = (enum HD44780_LCD_LINK) (lcd->I2CLink + 1);
+	}
+	lcd->I2CLinkTick = HAL_GetTick();
+}
+
+#endif
+
+/**
+ * @brief							Enables the backlight of the LCD (the function does not operate if the transport of the LCD does not drive the backlight)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_enableBacklight(HD44780_LCD_t *lcd) {
+	lcd->backlight = 1;
+	return lcd->transport->writeBacklight(lcd);
+}
+
+/**
+ * @brief							Disables the backlight of the LCD (the function does not operate if the transport of the LCD does not drive the backlight)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_disableBacklight(HD44780_LCD_t *lcd) {
+	lcd->backlight = 0;
+	return lcd->transport->writeBacklight(lcd);
+}
+
+/**
+ * @brief							Toggles the backlight of the LCD (the function does not operate if the transport of the LCD does not drive the backlight)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_toggleBacklight(HD44780_LCD_t *lcd) {
+	lcd->backlight ^= 1;
+	return lcd->transport->writeBacklight(lcd);
+}
+
+#if LCD_USE_GPIO
+/**
+ * @brief							Sends a nibble (4-bits) of information to the LCD when it is used in 4-bit mode (the information can be data or instructions, which must be determined by the caller)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		nibble				Nibble of data to transmit (only the lower 4 bits of this are considered)
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+HAL_StatusTypeDef LCD_sendNibble(HD44780_LCD_t *lcd, uint8_t nibble) {
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		LCD_WRITE_PIN(lcd->dataPins[i], (nibble >> i) & 1);
+	}
+
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_SET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_RESET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Sends a byte (8-bits) of information to the LCD when it is used in 8-bit mode (the information can be data or instructions, which must be determined by the caller)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		byte				Byte of data to transmit
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+HAL_StatusTypeDef LCD_sendByte(HD44780_LCD_t *lcd, uint8_t byte) {
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		LCD_WRITE_PIN(lcd->dataPins[i], (byte >> i) & 1);
+	}
+
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_SET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_RESET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Shifts out a byte of information to the LCD when it is used with a shift register (the information can be data or instructions, which must be determined by the caller)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		byte				Byte of data to transmit
+ *
+ * @return							Status of the transfer to the LCD (always HAL_OK)
+ */
+HAL_StatusTypeDef LCD_shiftByte(HD44780_LCD_t *lcd, uint8_t byte) {
+	for (uint32_t i = 0; i < 8; ++i) {
+		LCD_WRITE_PIN(lcd->DATA_PIN, (byte >> (i)) & 1);
+		LCD_WRITE_PIN(lcd->CLOCK_PIN, GPIO_PIN_SET);
+		// HAL_Delay(1);
+		LCD_WRITE_PIN(lcd->CLOCK_PIN, GPIO_PIN_RESET);
+	}
+	LCD_WRITE_PIN(lcd->LATCH_PIN, GPIO_PIN_SET);
+	// HAL_Delay(1);
+	LCD_WRITE_PIN(lcd->LATCH_PIN, GPIO_PIN_RESET);
+
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_SET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+	LCD_WRITE_PIN(lcd->enPin, GPIO_PIN_RESET);
+	LCD_delayUs(LCD_ENABLE_PULSE_US);
+
+	return HAL_OK;
+}
+
+#endif
 
-	lcd->dataPort[0] = port0;
-	lcd->dataPort[1] = port1;
-	lcd->dataPort[2] = port2;
-	lcd->dataPort[3] = port3;
+#if LCD_USE_I2C
+/**
+ * @brief							Sends a nibble of information to the LCD when it is used with a PC8574 I2C driver (the caller must also specify whether the information is data or an instruction)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		nibble				Nibble of data to send (only the lower 4-bits are considered)
+ * @param		isData				Whether the Nibble is an instruction (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_sendNibbleI2C(HD44780_LCD_t *lcd, uint8_t nibble, uint8_t isData) {
 
-	lcd->dataPin[0] = pin0;
-	lcd->dataPin[1] = pin1;
-	lcd->dataPin[2] = pin2;
-	lcd->dataPin[3] = pin3;
+	// the pin map and the backlight are already merged into the pre-encoded values
+	uint8_t result	= LCD_I2C_NIBBLE(lcd, isData & 1, nibble & 0x0F);
 
-	lcd->enPort = enPort;
-	lcd->rsPort = rsPort;
+	uint8_t buf[3];
+	buf[0] = result;
+	buf[1] = result | (1 << lcd->expanderPins.en);
+	buf[2] = result;
 
-	lcd->enPin = enPin;
-	lcd->rsPin = rsPin;
+	return LCD_transmitI2C(lcd, buf, 3);
 }
 
 /**
- * @brief							Initializes an LCD structure to operate the HD44780 controller in 4-bit mode
+ * @brief							Sends data already encoded into the frames of a PC8574 Expander (e.g. by hd44780::pcf8574Text) in a single transfer, without encoding any of it
+ *
+ * The frames hold 6 bytes per byte of data (each nibble with EN low, high and low again), encoded with the pin map and the state of the backlight
+ * of the LCD. The data is sent through the transport instead if the frames do not match them, or if the LCD is not driven by a PC8574 Expander or
+ * its link is offline
  *
  * @param		lcd					Pointer to LCD structure
- * @param		port0				GPIO Port on which pin D0 of the LCD is connected
- * @param		pin0				GPIO Pin number within the port to which pin D0 of the LCD is connected
- * @param		port1				GPIO Port on which pin D1 of the LCD is connected
- * @param		pin1				GPIO Pin number within the port to which pin D1 of the LCD is connected
- * @param		port2				GPIO Port on which pin D2 of the LCD is connected
- * @param		pin2				GPIO Pin number within the port to which pin D2 of the LCD is connected
- * @param		port3				GPIO Port on which pin D3 of the LCD is connected
- * @param		pin3				GPIO Pin number within the port to which pin D3 of the LCD is connected\
- * @param		port4				GPIO Port on which pin D4 of the LCD is connected
- * @param		pin4				GPIO Pin number within the port to which pin D4 of the LCD is connected
- * @param		port5				GPIO Port on which pin D5 of the LCD is connected
- * @param		pin5				GPIO Pin number within the port to which pin D5 of the LCD is connected
- * @param		port6				GPIO Port on which pin D6 of the LCD is connected
- * @param		pin6				GPIO Pin number within the port to which pin D6 of the LCD is connected
- * @param		port7				GPIO Port on which pin D7 of the LCD is connected
- * @param		pin7				GPIO Pin number within the port to which pin D7 of the LCD is connected
- * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
- * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
- * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
- * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ * @param		frames				Pointer to the frames
+ * @param		data				Pointer to the data the frames encode (which the shadow buffer is updated with)
+ * @param		len					Number of bytes of data
+ *
+ * @return							Status of the transfer to the LCD
  */
-void LCD_createFullBus(HD44780_LCD_t *lcd, GPIO_TypeDef *port0, uint16_t pin0,
-		GPIO_TypeDef *port1, uint16_t pin1, GPIO_TypeDef *port2, uint16_t pin2,
-		GPIO_TypeDef *port3, uint16_t pin3, GPIO_TypeDef *port4, uint16_t pin4,
-		GPIO_TypeDef *port5, uint16_t pin5, GPIO_TypeDef *port6, uint16_t pin6,
-		GPIO_TypeDef *port7, uint16_t pin7, GPIO_TypeDef *enPort,
-		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
-	lcd->busMode = fullBus;
+HAL_StatusTypeDef LCD_sendFramesI2C(HD44780_LCD_t *lcd, const uint8_t *frames, const uint8_t *data, uint32_t len) {
+	uint8_t first;
 
-	lcd->dataPort[0] = port0;
-	lcd->dataPort[1] = port1;
-	lcd->dataPort[2] = port2;
-	lcd->dataPort[3] = port3;
-	lcd->dataPort[4] = port4;
-	lcd->dataPort[5] = port5;
-	lcd->dataPort[6] = port6;
-	lcd->dataPort[7] = port7;
+	if (lcd->transport != &LCD_PCF8574 || !LCD_isOnline(lcd) || len == 0 || len > 0xFFFF / 6) {
+		return LCD_sendBuffer(lcd, data, len);
+	}
 
-	lcd->dataPin[0] = pin0;
-	lcd->dataPin[1] = pin1;
-	lcd->dataPin[2] = pin2;
-	lcd->dataPin[3] = pin3;
-	lcd->dataPin[4] = pin4;
-	lcd->dataPin[5] = pin5;
-	lcd->dataPin[6] = pin6;
-	lcd->dataPin[7] = pin7;
+	// the first nibble is enough to tell whether the frames were encoded with the pin map and the backlight of the LCD
+	first = LCD_I2C_NIBBLE(lcd, 1, HI_NIBBLE(data[0]));
+	if (frames[0] != first || frames[1] != (first | (1 << lcd->expanderPins.en))) {
+		return LCD_sendBuffer(lcd, data, len);
+	}
 
-	lcd->enPort = enPort;
-	lcd->rsPort = rsPort;
+	for (uint32_t i = 0; i < len; ++i) {
+		LCD_trackData(lcd, data[i]);
+	}
 
-	lcd->enPin = enPin;
-	lcd->rsPin = rsPin;
+	return LCD_transmitI2C(lcd, (uint8_t *) frames, len * 6);
 }
 
 /**
- * @brief							Initializes the LCD to be used along with a 74HC595 Shift Register
+ * @brief							Transmits a frame to the I2C Expander with a bounded timeout, re-attempting it according to the retry policy of the LCD
  *
- * The Shift Register is used to operate the LCD in 8-bit mode, and the wiring should be done in reverse order, i.e.
- * Shift Register O0 is wired to LCD D7, O1 to D6 etc.
- * he RS and En pins are not operated by the Shift Register and must be directly wired to the microcontroller
+ * After LCD_I2C_MAX_FAILURES consecutive frames fail, the LCD is marked as offline and further frames fail immediately without using the bus, until LCD_recoverI2C succeeds
  *
  * @param		lcd					Pointer to LCD structure
- * @param		dataPort			GPIO Port on which the Data-In pin of the Shift Register is connected
- * @param		dataPin				GPIO Pin within the Port to which the Data-In pin of the Shift Register is connected
- * @param		clockPort			GPIO Port on which the Clock-In pin of the Shift Register is connected
- * @param		clockPin			GPIO Pin within the Port to which the Clock-In pin of the Shift Register is connected
- * @param		latchPort			GPIO Port on which the Output-Latch pin of the Shift Register is connected
- * @param		latchPin			GPIO Pin within the Port to which the Output-Latch pin of the Shift Register is connected
- * @param		enPort				GPIO Port on which the Enable (En) pin of the LCD is connected
- * @param		enPin				GPIO Pin number within the port to which the Enable (En) pin of the LCD is connected
- * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the LCD is connected
- * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the LCD is connected
+ * @param		buf					Pointer to the frame
+ * @param		len					Length of the frame
+ *
+ * @return							HAL_OK if the frame was transmitted, otherwise the status of the last attempt
  */
-void LCD_createShiftRegister(HD44780_LCD_t *lcd, GPIO_TypeDef *dataPort,
-		uint16_t dataPin, GPIO_TypeDef *clockPort, uint16_t clockPin,
-		GPIO_TypeDef *latchPort, uint16_t latchPin, GPIO_TypeDef *enPort,
-		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
-	lcd->busMode = shiftReg;
+HAL_StatusTypeDef LCD_transmitI2C(HD44780_LCD_t *lcd, uint8_t *buf, uint16_t len) {
+	HAL_StatusTypeDef status;
+
+	if (lcd->I2CLink == linkOffline) {
+		++lcd->I2CStats.dropped;
+		return HAL_ERROR;
+	}
 
-	lcd->DATA_PORT= dataPort;
-	lcd->CLOCK_PORT= clockPort;
-	lcd->LATCH_PORT= latchPort;
+	for (uint32_t attempt = 0;; ++attempt) {
 
-	lcd->DATA_PIN= dataPin;
-	lcd->CLOCK_PIN= clockPin;
-	lcd->LATCH_PIN= latchPin;
+		// the error code of the previous attempt must not decide how a busy bus detected below is recovered
+		lcd->I2CHandle->ErrorCode = HAL_I2C_ERROR_NONE;
 
-	lcd->enPort = enPort;
-	lcd->rsPort = rsPort;
+		// the HAL waits up to 25ms for a busy bus to become free, so a bus held busy is detected here instead
+		if (__HAL_I2C_GET_FLAG(lcd->I2CHandle, I2C_FLAG_BUSY)) {
+			status = HAL_BUSY;
+		} else {
+#if LCD_USE_LL
+			status = LCD_masterTransmitLL(lcd, buf, len, LCD_I2C_TIMEOUT(len));
+#else
+			status = HAL_I2C_Master_Transmit(lcd->I2CHandle, lcd->I2CAddr, buf, len, LCD_I2C_TIMEOUT(len));
+#endif
+		}
+
+		if (status == HAL_OK) {
+			lcd->I2CFailures = 0;
+			return HAL_OK;
+		}
+
+		if (status == HAL_BUSY) {
+			++lcd->I2CStats.busError;
+		} else if (lcd->I2CHandle->ErrorCode & HAL_I2C_ERROR_AF) {
+			++lcd->I2CStats.nack;
+		} else if (status == HAL_TIMEOUT || (lcd->I2CHandle->ErrorCode & HAL_I2C_ERROR_TIMEOUT)) {
+			++lcd->I2CStats.timeout;
+		} else {
+			++lcd->I2CStats.busError;
+		}
+
+		if (attempt >= lcd->I2CRetries) {
+			break;
+		}
+		++lcd->I2CStats.retries;
+
+		// a NACK only means that the expander did not respond, every other failure can leave the bus stuck
+		if (!(lcd->I2CHandle->ErrorCode & HAL_I2C_ERROR_AF)) {
+			LCD_clearI2CBus(lcd);
+		}
+	}
+
+	++lcd->I2CStats.dropped;
+	if (++lcd->I2CFailures >= LCD_I2C_MAX_FAILURES) {
+		lcd->I2CLink = linkOffline;
+		lcd->I2CLinkTick = HAL_GetTick();
+	}
 
-	lcd->enPin = enPin;
-	lcd->rsPin = rsPin;
+	return status;
 }
 
+#endif
+
+#if LCD_USE_CMSIS_RTOS2
 /**
- * @brief							Initializes the LCD to be used along with a PC8574 Driver controlled via I2C at address 0x27
+ * @brief							Sleeps for at least the given number of microseconds if called from a task while the kernel is running, so other tasks run in the meantime
  *
- * @param		lcd					Pointer to LCD structure
- * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		us					Number of microseconds to sleep for
+ *
+ * @return							1 if the caller slept, 0 if it must busy-wait instead (it is an interrupt handler, or the kernel is not running or is locked)
  */
-void LCD_createI2C(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle) {
-	LCD_createI2C_addr(lcd, I2CHandle, DEFAULT_I2C_ADDR);
+static uint8_t LCD_sleepUs(uint32_t us) {
+	if (__get_IPSR() != 0U || osKernelGetState() != osKernelRunning) {
+		return 0;
+	}
+
+	// osDelay returns at the given tick interrupt, so the tick already in progress is not counted
+	osDelay((us * osKernelGetTickFreq() + 999999U) / 1000000U + 1U);
+	return 1;
 }
+#endif
 
 /**
- * @brief							Initializes the LCD to be used along with a PC8574 Driver controlled via I2C
+ * @brief							Busy-waits for the given number of microseconds by counting SysTick cycles (SysTick must be running, which HAL_Init ensures)
  *
- * @param		lcd					Pointer to LCD structure
- * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
- * @param		lcdAddr				Address of the module on the I2C bus
+ * With LCD_USE_CMSIS_RTOS2, waits of at least LCD_RTOS_SLEEP_US made by a task sleep instead
  *
+ * @param		us					Number of microseconds to wait for
  */
-void LCD_createI2C_addr(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr) {
+void LCD_delayUs(uint32_t us) {
+#if LCD_USE_CMSIS_RTOS2
+	if (us >= LCD_RTOS_SLEEP_US && LCD_sleepUs(us)) {
+		return;
+	}
+#endif
 
-	lcd->busMode = I2C;
-	lcd->I2CHandle = I2CHandle;
-	lcd->I2CAddr = lcdAddr;
+	const uint32_t reload = SysTick->LOAD + 1;
+	const uint32_t ticks = us * (SystemCoreClock / 1000000);
+
+	uint32_t elapsed = 0;
+	uint32_t last = SysTick->VAL;
 
-	lcd->backlightMask = 1 << 3;
+	while (elapsed < ticks) {
+		const uint32_t now = SysTick->VAL;
+		elapsed += (last >= now) ? (last - now) : (last + reload - now);
+		last = now;
+	}
 }
 
 /**
- * @brief							Enables the backlight of the LCD (the function does not operate if the LCD is not being driven via I2C)
+ * @brief							Configures a transport that needs no configuration (e.g. GPIO Pins, the PC8574 Expander and controllers without registers to set up, so nothing is sent)
  *
  * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_OK
  */
-void LCD_enableBacklight(HD44780_LCD_t *lcd) {
-	if (lcd->busMode == I2C) {
-		lcd->backlightMask	= (1 << BACKLIGHT_ID);
-		HAL_I2C_Master_Transmit(lcd->I2CHandle, lcd->I2CAddr, (uint8_t *)&(lcd->backlightMask), 1, HAL_MAX_DELAY);
-	}
+HAL_StatusTypeDef LCD_configureNone(HD44780_LCD_t *lcd) {
+	(void) lcd;
+	return HAL_OK;
 }
 
 /**
- * @brief							Disables the backlight of the LCD (the function does not operate if the LCD is not being driven via I2C)
+ * @brief							Updates the state of the backlight of a transport that does not drive it (nothing is sent)
  *
  * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_OK
  */
-void LCD_disableBacklight(HD44780_LCD_t *lcd) {
-	if (lcd->busMode == I2C) {
-		lcd->backlightMask	= 0;
-		HAL_I2C_Master_Transmit(lcd->I2CHandle, lcd->I2CAddr, (uint8_t *)&(lcd->backlightMask), 1, HAL_MAX_DELAY);
-	}
+HAL_StatusTypeDef LCD_writeBacklightNone(HD44780_LCD_t *lcd) {
+	(void) lcd;
+	return HAL_OK;
 }
 
 /**
- * @brief							Toggles the backlight of the LCD (the function does not operate if the LCD is not being driven via I2C)
+ * @brief							Sends a single-byte instruction with the parameter bitmask to the LCD's Instruction Register
  *
  * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction with parameter bitmask
+ *
+ * @return							Status of the transfer to the LCD
  */
-void LCD_toggleBacklight(HD44780_LCD_t *lcd) {
-	if (lcd->busMode == I2C) {
-		lcd->backlightMask ^= (1 << BACKLIGHT_ID);
-		HAL_I2C_Master_Transmit(lcd->I2CHandle, lcd->I2CAddr, (uint8_t *)&(lcd->backlightMask), 1, HAL_MAX_DELAY);
+HAL_StatusTypeDef LCD_sendInstruction(HD44780_LCD_t *lcd, uint8_t instruction) {
+	HAL_StatusTypeDef status;
+
+	LCD_trackInstruction(lcd, instruction);
+
+#if LCD_USE_I2C
+	if (lcd->I2CLink != linkOnline) {
+		return LCD_deferI2C(lcd);
 	}
+#endif
+
+	status = LCD_writeRaw(lcd, instruction, 0);
+	if (status == HAL_OK) {
+		LCD_waitExec(lcd, instruction, 0);
+	}
+
+	return status;
 }
 
 /**
- * @brief							Sends a nibble (4-bits) of information to the LCD when it is used in 4-bit mode (the information can be data or instructions, which must be determined by the caller)
+ * @brief							Sends a single-byte instruction with the parameter bitmask to the LCD's Instruction Register without waiting for it to be executed
+ *
+ * Clearing the display and returning home take longer than the transport waits for, so the caller must let execUs microseconds pass before the next
+ * transfer (e.g. with a timer, instead of busy-waiting as LCD_sendInstruction does)
  *
  * @param		lcd					Pointer to LCD structure
- * @param		nibble				Nibble of data to transmit (only the lower 4 bits of this are considered)
+ * @param		instruction			Instruction with parameter bitmask
+ * @param		execUs				Pointer to where the number of microseconds to wait before the next transfer is stored
+ *
+ * @return							Status of the transfer to the LCD
  */
-void LCD_sendNibble(HD44780_LCD_t *lcd, uint8_t nibble) {
+HAL_StatusTypeDef LCD_startInstruction(HD44780_LCD_t *lcd, uint8_t instruction, uint32_t *execUs) {
+	HAL_StatusTypeDef status;
 
-	for (uint32_t i = 0; i < 4; ++i) {
-		HAL_GPIO_WritePin(lcd->dataPort[i], lcd->dataPin[i], (nibble >> i) & 1);
+	*execUs = 0;
+	LCD_trackInstruction(lcd, instruction);
+
+#if LCD_USE_I2C
+	if (lcd->I2CLink != linkOnline) {
+		return LCD_deferI2C(lcd);
+	}
+#endif
+
+	status = LCD_writeRaw(lcd, instruction, 0);
+	if (status == HAL_OK) {
+		*execUs = LCD_execUs(lcd, instruction, 0);
 	}
 
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_SET);
-	HAL_Delay(1);
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_RESET);
-	HAL_Delay(1);
+	return status;
 }
 
 /**
- * @brief							Sends a byte (8-bits) of information to the LCD when it is used in 8-bit mode (the information can be data or instructions, which must be determined by the caller)
+ * @brief							Sends a single-byte of data to the LCD's Data Register
  *
  * @param		lcd					Pointer to LCD structure
- * @param		byte				Byte of data to transmit
+ * @param		data				Data to send
+ *
+ * @return							Status of the transfer to the LCD
  */
-void LCD_sendByte(HD44780_LCD_t *lcd, uint8_t byte) {
+HAL_StatusTypeDef LCD_sendData(HD44780_LCD_t *lcd, const uint8_t data) {
+	HAL_StatusTypeDef status;
 
-	for (uint32_t i = 0; i < 8; ++i) {
-		HAL_GPIO_WritePin(lcd->dataPort[i], lcd->dataPin[i], (byte >> i) & 1);
+	LCD_trackData(lcd, data);
+
+#if LCD_USE_I2C
+	if (lcd->I2CLink != linkOnline) {
+		return LCD_deferI2C(lcd);
+	}
+#endif
+
+	status = LCD_writeRaw(lcd, data, 1);
+	if (status == HAL_OK) {
+		LCD_waitExec(lcd, data, 1);
 	}
 
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_SET);
-	HAL_Delay(1);
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_RESET);
-	HAL_Delay(1);
+	return status;
 }
 
 /**
- * @brief							Shifts out a byte of information to the LCD when it is used with a shift register (the information can be data or instructions, which must be determined by the caller)
+ * @brief							Sends a sequence of bytes with fixed length to the LCD's Data Register
  *
  * @param		lcd					Pointer to LCD structure
- * @param		byte				Byte of data to transmit
+ * @param		buf					Pointer to Data Buffer
+ * @param		len					Length of Data Buffer
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first byte that fails)
  */
-void LCD_shiftByte(HD44780_LCD_t *lcd, uint8_t byte) {
-	for (uint32_t i = 0; i < 8; ++i) {
-		HAL_GPIO_WritePin(lcd->DATA_PORT, lcd->DATA_PIN, (byte >> (i)) & 1);
-		HAL_GPIO_WritePin(lcd->CLOCK_PORT, lcd->CLOCK_PIN, GPIO_PIN_SET);
-		// HAL_Delay(1);
-		HAL_GPIO_WritePin(lcd->CLOCK_PORT, lcd->CLOCK_PIN, GPIO_PIN_RESET);
+HAL_StatusTypeDef LCD_sendBuffer(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	// the whole buffer is handed to the transport, which may stream it in fewer transfers
+	if (LCD_isOnline(lcd)) {
+		for (uint32_t i = 0; i < len; ++i) {
+			LCD_trackData(lcd, buf[i]);
+		}
+		return lcd->transport->write(lcd, buf, len, 1);
 	}
-	HAL_GPIO_WritePin(lcd->LATCH_PORT, lcd->LATCH_PIN, GPIO_PIN_SET);
-	// HAL_Delay(1);
-	HAL_GPIO_WritePin(lcd->LATCH_PORT, lcd->LATCH_PIN, GPIO_PIN_RESET);
 
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_SET);
-	HAL_Delay(1);
-	HAL_GPIO_WritePin(lcd->enPort, lcd->enPin, GPIO_PIN_RESET);
-	HAL_Delay(1);
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		status = LCD_sendData(lcd, buf[i]);
+	}
+
+	return status;
 }
 
 /**
- * @brief							Sends a nibble of information to the LCD when it is used with the I2C driver (the caller must also specify whether the information is data or an instruction)
+ * @brief							Sends a sequence of single-byte instructions with their parameter bitmasks to the LCD's Instruction Register
+ *
+ * Unless one of them clears the display or returns home, the instructions are handed to the transport together, which may stream them in fewer transfers
  *
  * @param		lcd					Pointer to LCD structure
- * @param		nibble				Nibble of data to send (only the lower 4-bits are considered)
- * @param		isData				Whether the Nibble is an instruction (0) or Data (1)
+ * @param		buf					Pointer to the instructions
+ * @param		len					Number of instructions
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first instruction that fails)
  */
-void LCD_sendNibbleI2C(HD44780_LCD_t *lcd, uint8_t nibble, uint8_t isData) {
+HAL_StatusTypeDef LCD_sendInstructions(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len) {
+	HAL_StatusTypeDef status = HAL_OK;
+	uint8_t stream = LCD_isOnline(lcd);
 
-	uint8_t result	= (nibble << 4) | (isData << RS_ID) | lcd->backlightMask;
+	for (uint32_t i = 0; i < len && stream; ++i) {
+		stream = LCD_execUs(lcd, buf[i], 0) == 0;
+	}
 
-	uint8_t buf[3];
-	buf[0] = result;
-	buf[1] = result | (1 << EN_ID);
-	buf[2] = result;
+	if (stream) {
+		for (uint32_t i = 0; i < len; ++i) {
+			LCD_trackInstruction(lcd, buf[i]);
+		}
+		return lcd->transport->write(lcd, buf, len, 0);
+	}
 
-	HAL_I2C_Master_Transmit(lcd->I2CHandle, lcd->I2CAddr, buf, 3, HAL_MAX_DELAY);
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		status = LCD_sendInstruction(lcd, buf[i]);
+	}
+
+	return status;
 }
 
 /**
- * @brief							Sends a single-byte instruction with the parameter bitmask to the LCD's Instruction Register
+ * @brief							Initializes the LCD module after the LCD structure has been initialized
  *
  * @param		lcd					Pointer to LCD structure
- * @param		instruction			Instruction with parameter bitmask
+ *
+ * @return							Status of the transfers to the LCD (the initialization stops at the first transfer that fails)
  */
-void LCD_sendInstruction(HD44780_LCD_t *lcd, uint8_t instruction) {
+HAL_StatusTypeDef LCD_init(HD44780_LCD_t *lcd) {
+	const HD44780_LCD_Variant_t *variant = lcd->variant;
+	HAL_StatusTypeDef status = HAL_OK;
 
-	switch (lcd->busMode) {
-	case halfBus:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_RESET);
-		LCD_sendNibble(lcd, HI_NIBBLE(instruction));
-		LCD_sendNibble(lcd, LO_NIBBLE(instruction));
-		break;
-	case fullBus:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_RESET);
-		LCD_sendByte(lcd, instruction);
-		break;
-	case shiftReg:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_RESET);
-		LCD_shiftByte(lcd, instruction);
-		break;
-	case I2C:
-		LCD_sendNibbleI2C(lcd, HI_NIBBLE(instruction), 0);
-		LCD_sendNibbleI2C(lcd, LO_NIBBLE(instruction), 0);
-		break;
+	lcd->displayState = LCD_DISPLAY_ENABLE | LCD_CURSOR_DISABLE
+			| LCD_BLINK_DISABLE;
+	lcd->cursorMovement = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
+	LCD_resetShadow(lcd);
+
+	// an LCD that is offline or being re-attached is initialized by LCD_serviceI2C instead
+	if (!LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+
+	LCD_delayUs(variant->powerUpMs * 1000U);
+
+	status = lcd->transport->configure(lcd);
+	for (uint32_t i = 0; i < 3 && status == HAL_OK; ++i) {
+		status = lcd->transport->writeInit(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_8);
+		LCD_delayUs(variant->wakeUs);
+	}
+	if (status == HAL_OK && lcd->transport->busSize == LCD_BUS_SIZE_4) {
+		status = lcd->transport->writeInit(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_4);
+		LCD_delayUs(variant->execUs);
+	}
+
+	if (status == HAL_OK) {
+		status = LCD_sendInstruction(lcd, LCD_functionSet(lcd));
+	}
+	if (status == HAL_OK && variant->setupLen != 0) {
+		status = LCD_writeSequence(lcd, variant->setup, variant->setupLen);
+	}
+	if (status == HAL_OK && variant->contrastLen != 0) {
+		status = LCD_writeContrast(lcd);
+	}
+
+	const uint8_t setup[] = {
+		LCD_CLEAR_DISPLAY,
+		LCD_SET_CURSOR_HOME,
+		LCD_CONTROL_DISPLAY | lcd->displayState,
+		LCD_SET_ENTRY_MODE | lcd->cursorMovement
 	};
+
+	// each instruction waits for its own execution time, according to the variant of the controller
+	for (uint32_t i = 0; i < sizeof(setup) && status == HAL_OK; ++i) {
+		status = LCD_sendInstruction(lcd, setup[i]);
+	}
+
+	return status;
 }
 
 /**
- * @brief							Sends a single-byte of data to the LCD's Data Register
+ * @brief							Sets the variant of the controller of the LCD, which selects its timing, initialization sequence and extended commands (must be called before LCD_init)
+ *
+ * LCDs are created with the HD44780 variant, except for those whose controller is known from the function that created them
  *
  * @param		lcd					Pointer to LCD structure
- * @param		data				Data to send
+ * @param		variant				Pointer to the variant (LCD_VARIANT_HD44780, LCD_VARIANT_KS0066, LCD_VARIANT_ST7066U, LCD_VARIANT_SPLC780D, LCD_VARIANT_US2066, LCD_VARIANT_WS0010 or a user-defined variant)
  */
-void LCD_sendData(HD44780_LCD_t *lcd, const uint8_t data) {
-	switch (lcd->busMode) {
-	case halfBus:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_SET);
-		LCD_sendNibble(lcd, HI_NIBBLE(data));
-		LCD_sendNibble(lcd, LO_NIBBLE(data));
-		break;
-	case fullBus:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_SET);
-		LCD_sendByte(lcd, data);
-		break;
-	case shiftReg:
-		HAL_GPIO_WritePin(lcd->rsPort, lcd->rsPin, GPIO_PIN_SET);
-		LCD_shiftByte(lcd, data);
-		break;
-	case I2C:
-		LCD_sendNibbleI2C(lcd, HI_NIBBLE(data), 1);
-		LCD_sendNibbleI2C(lcd, LO_NIBBLE(data), 1);
-		break;
+void LCD_setVariant(HD44780_LCD_t *lcd, const HD44780_LCD_Variant_t *variant) {
+	lcd->variant = variant;
+	lcd->functionFlags = variant->functionSet;
+
+	if (variant->contrastLen != 0) {
+		lcd->contrast = variant->defaultContrast;
 	}
 }
 
 /**
- * @brief							Sends a sequence of bytes with fixed length to the LCD's Data Register
+ * @brief							Encodes a GPIO Port and Pin into the two bytes stored in the LCD structure
+ *
+ * @param		port				GPIO Port (GPIOA to GPIOF)
+ * @param		pin					GPIO Pin mask within the port (exactly one of GPIO_PIN_0 to GPIO_PIN_15)
+ *
+ * @return							Index of the port and number of the pin
+ */
+HD44780_LCD_Pin_t LCD_encodePin(GPIO_TypeDef *port, uint16_t pin) {
+	HD44780_LCD_Pin_t result;
+
+	// the ports are 1KB apart on the IOPORT bus, starting with GPIOA
+	result.port = (uint8_t) (((uint32_t) port - IOPORT_BASE) >> 10);
+	result.pin = 0;
+	while (pin > 1) {
+		pin >>= 1;
+		++result.pin;
+	}
+
+	return result;
+}
+
+/**
+ * @brief							Sends a sequence of instructions and data to the LCD without affecting its shadow buffer, waiting for each to be executed (used for commands specific to a variant of the controller)
+ *
+ * The function set of the LCD is sent after the sequence, so the sequence may leave the controller in an extended instruction set
  *
  * @param		lcd					Pointer to LCD structure
- * @param		buf					Pointer to Data Buffer
- * @param		len					Length of Data Buffer
+ * @param		seq					Pointer to the sequence (entries flagged with LCD_SEQ_DATA are data, and entries flagged with LCD_SEQ_FUNCTION get the bus size of the LCD)
+ * @param		len					Number of entries in the sequence
+ *
+ * @return							Status of the transfers to the LCD (the sequence stops at the first entry that fails)
+ */
+HAL_StatusTypeDef LCD_sendSequence(HD44780_LCD_t *lcd, const uint16_t *seq, uint32_t len) {
+	if (!LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+	return LCD_writeSequence(lcd, seq, len);
+}
+
+/**
+ * @brief							Applies a transfer made without the library (e.g. a compiled screen replayed by DMA) to the shadow buffer of the LCD, as if the library had made it
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes of the transfer
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
  */
-void LCD_sendBuffer(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len) {
+void LCD_trackTransfer(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
 	for (uint32_t i = 0; i < len; ++i) {
-		LCD_sendData(lcd, buf[i]);
+		if (isData) {
+			LCD_trackData(lcd, buf[i]);
+		} else {
+			LCD_trackInstruction(lcd, buf[i]);
+		}
 	}
 }
 
 /**
- * @brief							Initializes the LCD module after the LCD structure has been initialized
+ * @brief							Sets the contrast of the LCD (only applicable to ST7032/ST7036 controllers and to variants that support it, such as the US2066, where it sets the brightness)
+ *
+ * The contrast is kept even if the LCD is offline, and is restored whenever the LCD is initialized
  *
  * @param		lcd					Pointer to LCD structure
+ * @param		contrast			Contrast of the LCD (0 to LCD_EXT_CONTRAST_MAX on ST7032/ST7036 controllers, 0 to 255 on the US2066)
+ *
+ * @return							Status of the transfer to the LCD (HAL_ERROR if the controller does not support it)
  */
-void LCD_init(HD44780_LCD_t *lcd) {
-	HAL_Delay(50);
+HAL_StatusTypeDef LCD_setContrast(HD44780_LCD_t *lcd, uint8_t contrast) {
+	const uint8_t viaController = lcd->transport->writeContrast != NULL;
 
-	lcd->displayState = LCD_DISPLAY_ENABLE | LCD_CURSOR_DISABLE
-			| LCD_BLINK_DISABLE;
-	lcd->cursorMovement = LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC;
+	if (!viaController && lcd->variant->contrastLen == 0) {
+		return HAL_ERROR;
+	}
 
-	switch (lcd->busMode) {
-	case halfBus:
-		for (uint32_t i = 0; i < 3; ++i) {
-			LCD_sendNibble(lcd, HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8));
-			HAL_Delay(5);
-		}
-		LCD_sendNibble(lcd, HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_4));
-		HAL_Delay(2);
-		LCD_sendInstruction(lcd,
-				LCD_SET_FUNCTION | LCD_BUS_SIZE_4 | LCD_DOT_COUNT_8
-						| LCD_LINE_COUNT_2);
-		break;
-	case fullBus:
-		for (uint32_t i = 0; i < 3; ++i) {
-			LCD_sendByte(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_8);
-			HAL_Delay(5);
-		}
-		LCD_sendInstruction(lcd,
-		LCD_SET_FUNCTION | LCD_BUS_SIZE_8 | LCD_DOT_COUNT_8 | LCD_LINE_COUNT_2);
-		break;
-	case shiftReg:
-		for (uint32_t i = 0; i < 3; ++i) {
-			LCD_shiftByte(lcd, LCD_SET_FUNCTION | LCD_BUS_SIZE_8);
-			HAL_Delay(5);
-		}
-		LCD_sendInstruction(lcd,
-		LCD_SET_FUNCTION | LCD_BUS_SIZE_8 | LCD_DOT_COUNT_8 | LCD_LINE_COUNT_2);
-		break;
-	case I2C:
-		for (uint32_t i = 0; i < 3; ++i) {
-			LCD_sendNibbleI2C(lcd, HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_8), 0);
-			HAL_Delay(5);
-		}
-		LCD_sendNibbleI2C(lcd, HI_NIBBLE(LCD_SET_FUNCTION | LCD_BUS_SIZE_4), 0);
-		HAL_Delay(2);
-		LCD_sendInstruction(lcd,
-						LCD_SET_FUNCTION | LCD_BUS_SIZE_4 | LCD_DOT_COUNT_8
-								| LCD_LINE_COUNT_2);
-		break;
+	lcd->contrast = contrast;
+	if (!LCD_isOnline(lcd)) {
+		return HAL_ERROR;
 	}
-	HAL_Delay(2);
 
-	LCD_sendInstruction(lcd, LCD_CLEAR_DISPLAY);
-	HAL_Delay(2);
+	return (viaController) ? (lcd->transport->writeContrast(lcd)) : (LCD_writeContrast(lcd));
+}
 
-	LCD_sendInstruction(lcd, LCD_SET_CURSOR_HOME);
-	HAL_Delay(2);
+/**
+ * @brief							Enables double-height characters (only applicable to variants that support them, such as the US2066)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD (HAL_ERROR if the variant does not support it)
+ */
+HAL_StatusTypeDef LCD_enableDoubleHeight(HD44780_LCD_t *lcd) {
+	if (lcd->variant->doubleHeight == 0) {
+		return HAL_ERROR;
+	}
 
-	LCD_sendInstruction(lcd, LCD_CONTROL_DISPLAY | lcd->displayState);
-	HAL_Delay(2);
+	lcd->functionFlags |= lcd->variant->doubleHeight;
+	return LCD_sendInstruction(lcd, LCD_functionSet(lcd));
+}
 
-	LCD_sendInstruction(lcd, LCD_SET_ENTRY_MODE | lcd->cursorMovement);
-	HAL_Delay(2);
+/**
+ * @brief							Disables double-height characters (only applicable to variants that support them, such as the US2066)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD (HAL_ERROR if the variant does not support it)
+ */
+HAL_StatusTypeDef LCD_disableDoubleHeight(HD44780_LCD_t *lcd) {
+	if (lcd->variant->doubleHeight == 0) {
+		return HAL_ERROR;
+	}
+
+	lcd->functionFlags &= ~(lcd->variant->doubleHeight);
+	return LCD_sendInstruction(lcd, LCD_functionSet(lcd));
 }
 
 /**
@@ -648,11 +2098,53 @@ void LCD_scrollDisplayRight(HD44780_LCD_t *lcd) {
  * @param		lcd					Pointer to the LCD structure
  * @param		loc					Location in CGRAM (0-7) where the glyph must be stored
  * @param		ar					Glyph of the character represented as an array of bytes
+ *
+ * @return							Status of the transfers to the LCD
  */
-void LCD_createCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t glyph[8]) {
-	LCD_sendInstruction(lcd, LCD_SET_CGRAMADDR | (loc << 3));
+HAL_StatusTypeDef LCD_createCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t glyph[8]) {
+	HAL_StatusTypeDef status = LCD_sendInstruction(lcd, LCD_SET_CGRAMADDR | (loc << 3));
 
-	for (uint32_t i = 0; i < 8; ++i) {
-		LCD_sendData(lcd, glyph[i]);
+	if (status == HAL_OK) {
+		status = LCD_sendBuffer(lcd, glyph, 8);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Updates a custom glyph in the LCD's Character Memory, sending only the rows that differ from the shadow buffer
+ *
+ * The address counter is set only if it does not already point at the first row that changed, so glyphs updated in order of their locations
+ * often need no address instruction
+ *
+ * @param		lcd					Pointer to the LCD structure
+ * @param		loc					Location in CGRAM (0-7) where the glyph must be stored
+ * @param		glyph				Glyph of the character represented as an array of bytes
+ *
+ * @return							Status of the transfers to the LCD (HAL_OK without any transfer if the glyph is unchanged)
+ */
+HAL_StatusTypeDef LCD_updateCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t glyph[8]) {
+	HAL_StatusTypeDef status = HAL_OK;
+	uint32_t first = 8;
+	uint32_t last = 0;
+
+	for (uint32_t row = 0; row < 8; ++row) {
+		if (!LCD_SHADOW_CGRAM_IS(lcd, loc * 8 + row, glyph[row])) {
+			first = (first == 8) ? (row) : (first);
+			last = row;
+		}
+	}
+
+	if (first == 8) {
+		return HAL_OK;
 	}
+
+	if (!lcd->shadow.inCGRAM || lcd->shadow.addr != loc * 8 + first) {
+		status = LCD_sendInstruction(lcd, LCD_SET_CGRAMADDR | (loc * 8 + first));
+	}
+	if (status == HAL_OK) {
+		status = LCD_sendBuffer(lcd, &glyph[first], last - first + 1);
+	}
+
+	return status;
 }
@@ -11,6 +11,14 @@
 #ifndef HD44780_LCD_H_
 #define HD44780_LCD_H_
 
+#if LCD_USE_CMSIS_RTOS2
+#include "cmsis_os2.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // get the lower nibble (4 least significant bits) of a byte
 #define   LO_NIBBLE(x)          (((x) >> 0) & 0x0f)
 
@@ -75,12 +83,40 @@
 // mask to denote that the bus is 8 lines wide
 #define   LCD_BUS_SIZE_8        0x10
 
+// mask to denote that the extended instruction table is selected (only applicable to ST7032/ST7036 controllers)
+#define   LCD_EXT_TABLE         0x01
+
 // instruction to set the address in the CGRAM (where the subsequent data will be written to)
 #define   LCD_SET_CGRAMADDR     0x40
 
 // instruction to set the address in the DDRAM (where the subsequent data will be written to)
 #define   LCD_SET_DDRAMADDR     0x80
 
+// extended instruction to set the bias voltage and the frequency of the internal oscillator (only applicable to ST7032/ST7036 controllers)
+#define   LCD_EXT_SET_BIAS_OSC  0x10
+// mask to denote a bias of 1/4 (the bias is 1/5 otherwise)
+#define   LCD_EXT_BIAS_4        0x08
+// mask to denote the default frequency of the internal oscillator
+#define   LCD_EXT_OSC_DEFAULT   0x04
+// extended instruction to set the address in the ICON RAM (where the subsequent data will be written to)
+#define   LCD_EXT_SET_ICONADDR  0x40
+// extended instruction to control the display of icons, the voltage booster and the 2 most significant bits of the contrast
+#define   LCD_EXT_POWER_ICON    0x50
+// mask to denote that the icons are displayed
+#define   LCD_EXT_ICON_ENABLE   0x08
+// mask to denote that the voltage booster is enabled
+#define   LCD_EXT_BOOST_ENABLE  0x04
+// extended instruction to control the voltage follower
+#define   LCD_EXT_FOLLOWER      0x60
+// mask to denote that the voltage follower is enabled (with the default amplification ratio)
+#define   LCD_EXT_FOLLOWER_ON   0x0C
+// extended instruction to set the 4 least significant bits of the contrast
+#define   LCD_EXT_SET_CONTRAST  0x70
+// the maximum contrast of ST7032/ST7036 controllers
+#define   LCD_EXT_CONTRAST_MAX  0x3F
+// the number of addresses in the ICON RAM (each holds 5 icons)
+#define   LCD_EXT_ICON_COUNT    0x10
+
 // address of the first position in single-line mode
 #define   LCD_ORIG_ADDR_SINGLE  0x00
 // address of the first position of the first line in two-line mode
@@ -89,6 +125,10 @@
 #define   LCD_ORIG_ADDR_SECOND  0x40
 // the width of a single line of the LCD
 #define   LCD_LINE_SIZE         0x28
+// the number of columns of each line that are visible at once (the rest of the line is off-screen until the display is shifted)
+#ifndef   LCD_VISIBLE_COLS
+#define   LCD_VISIBLE_COLS		16
+#endif
 
 // the default address of the I2C Peripheral that controls the LCD
 #define	  DEFAULT_I2C_ADDR		(0x27<<1)
@@ -102,34 +142,581 @@
 // the index of the bit that manages the backlight of the LCD
 #define	  BACKLIGHT_ID			3
 
+// the clock frequency of the I2C bus the LCD is connected to (used to size the timeout of each transfer)
+#ifndef   LCD_I2C_BUS_HZ
+#define   LCD_I2C_BUS_HZ		100000
+#endif
+// the number of times a failed I2C transfer is re-attempted before it is reported as failed
+#ifndef   LCD_I2C_DEFAULT_RETRIES
+#define   LCD_I2C_DEFAULT_RETRIES	2
+#endif
+// the number of consecutive failed I2C transfers after which the LCD is marked as offline (each has already been re-attempted, so the first one by default)
+#ifndef   LCD_I2C_MAX_FAILURES
+#define   LCD_I2C_MAX_FAILURES	1
+#endif
+// the interval (in milliseconds) at which an offline LCD is probed to detect that it has been re-attached
+#ifndef   LCD_I2C_PROBE_INTERVAL
+#define   LCD_I2C_PROBE_INTERVAL	100
+#endif
+// the number of bytes of the shadow buffer replayed to a re-attached LCD by each call to LCD_serviceI2C
+#ifndef   LCD_I2C_REPLAY_CHUNK
+#define   LCD_I2C_REPLAY_CHUNK	2
+#endif
+// the number of bytes streamed to the LCD in each I2C transfer by Expanders that stream several bytes per transfer (this sizes a buffer on the stack)
+#ifndef   LCD_I2C_STREAM_CHUNK
+#define   LCD_I2C_STREAM_CHUNK	8
+#endif
+// the timeout (in milliseconds) of an I2C transfer of the given length (9 clocks per byte, including the address, plus 1 tick of slack)
+#define   LCD_I2C_TIMEOUT(len)	(((((len) + 1) * 9 * 1000) + LCD_I2C_BUS_HZ - 1) / LCD_I2C_BUS_HZ + 1)
+// whether clocking the given number of bytes out on the I2C bus takes at least the given number of microseconds (9 clocks per byte)
+#define   LCD_I2C_COVERS_US(count, us)	((uint32_t) (count) * 9 * 1000000 >= (uint32_t) (us) * LCD_I2C_BUS_HZ)
+
+// the first address of the range of addresses used by PC8574 I2C Expanders (the last is 7 after it)
+#define   PCF8574_BASE_ADDR		(0x20<<1)
+// the first address of the range of addresses used by PC8574A I2C Expanders (the last is 7 after it)
+#define   PCF8574A_BASE_ADDR	(0x38<<1)
+
+// the default address of an MCP23008/MCP23017 I2C Expander (all address pins tied low)
+#define   MCP230XX_DEFAULT_ADDR	(0x20<<1)
+
+// the address of an ST7032i controller
+#define   ST7032_I2C_ADDR		(0x3E<<1)
+// the address of an ST7036i controller (with SA0 and SA1 tied low)
+#define   ST7036_I2C_ADDR		(0x3C<<1)
+// the address of an AiP31068L controller
+#define   AIP31068_I2C_ADDR		(0x3E<<1)
+
+// the contrast that ST7032/ST7036 controllers are initialized with
+#ifndef   LCD_EXT_DEFAULT_CONTRAST
+#define   LCD_EXT_DEFAULT_CONTRAST	0x20
+#endif
+// whether the voltage booster of ST7032/ST7036 controllers is enabled (LCD_EXT_BOOST_ENABLE for 3.3V supplies, 0 for 5V supplies)
+#ifndef   LCD_EXT_DEFAULT_BOOST
+#define   LCD_EXT_DEFAULT_BOOST	LCD_EXT_BOOST_ENABLE
+#endif
+// the execution time (in microseconds) of an instruction or data write on ST7032/ST7036 controllers (the execution time of LCD_VARIANT_ST7032)
+#ifndef   LCD_EXT_EXEC_US
+#define   LCD_EXT_EXEC_US		27
+#endif
+// the timeout (in milliseconds) of a single-byte SPI transfer
+#define   LCD_SPI_TIMEOUT		2
+
+// the address of a US2066 controller (with SA0 tied low)
+#define   US2066_I2C_ADDR		(0x3C<<1)
+
+// whether the pins of the LCD are written directly to the BSRR register of their port and I2C transfers are made with the Low-Layer (LL) drivers (1), or with the HAL (0)
+#ifndef   LCD_USE_LL
+#define   LCD_USE_LL			0
+#endif
+
+// whether LCDs can be driven via GPIO Pins in 4-bit mode, 8-bit mode or via a Shift Register (0 compiles them out)
+#ifndef   LCD_USE_GPIO
+#define   LCD_USE_GPIO			1
+#endif
+// whether LCDs can be driven via I2C, i.e. via I2C IO Expanders or controllers with a native I2C interface (0 compiles them out)
+#ifndef   LCD_USE_I2C
+#define   LCD_USE_I2C			1
+#endif
+// whether LCDs can be driven via SPI (enabled along with the SPI module of the HAL, 0 compiles them out)
+#ifndef   LCD_USE_SPI
+#ifdef    HAL_SPI_MODULE_ENABLED
+#define   LCD_USE_SPI			1
+#else
+#define   LCD_USE_SPI			0
+#endif
+#endif
+// whether a copy of the display and character memories of each LCD is kept (0 compiles it out, after which every character and glyph row is sent even if
+// the LCD already shows it, and a re-attached LCD is left cleared instead of being restored)
+#ifndef   LCD_USE_SHADOW
+#define   LCD_USE_SHADOW		1
+#endif
+// whether the values of the port of an I2C Expander are pre-encoded for every nibble (0 encodes each nibble as it is sent instead of storing 32 bytes per LCD)
+#ifndef   LCD_I2C_NIBBLE_TABLE
+#define   LCD_I2C_NIBBLE_TABLE	1
+#endif
+
+// the index of the port of a pin that is not connected
+#define   LCD_PORT_NONE			0xFF
+
+// get the GPIO Port of a pin of the LCD (a HD44780_LCD_Pin_t)
+#define   LCD_PIN_PORT(p)		((GPIO_TypeDef *)(IOPORT_BASE + ((uint32_t)(p).port << 10)))
+// get the mask of a pin of the LCD (a HD44780_LCD_Pin_t) within its GPIO Port
+#define   LCD_PIN_MASK(p)		((uint16_t)(1U << (p).pin))
+
+#if LCD_USE_SHADOW
+// whether the shadow buffer of an LCD records the given character at a cell of the DDRAM
+#define   LCD_SHADOW_DDRAM_IS(lcd, row, col, code)	((lcd)->shadow.ddram[row][col] == (code))
+// whether the shadow buffer of an LCD records the given value at a byte of the CGRAM
+#define   LCD_SHADOW_CGRAM_IS(lcd, pos, value)		((lcd)->shadow.cgram[pos] == (value))
+#else
+// without the shadow buffer nothing is known to be on the LCD, so every cell and byte of the CGRAM is sent
+#define   LCD_SHADOW_DDRAM_IS(lcd, row, col, code)	(0)
+#define   LCD_SHADOW_CGRAM_IS(lcd, pos, value)		(0)
+#endif
+
+#if LCD_I2C_NIBBLE_TABLE
+// get the value of the port of the I2C Expander of an LCD for a nibble with RS low (0) or high (1), and EN low
+#define   LCD_I2C_NIBBLE(lcd, isData, nibble)	((lcd)->I2CNibbles[isData][nibble])
+#else
+#define   LCD_I2C_NIBBLE(lcd, isData, nibble)	LCD_encodeI2CNibble(lcd, isData, nibble)
+#endif
+
+#if LCD_USE_LL
+// sets or resets a pin of the LCD (a HD44780_LCD_Pin_t) with a single write to the BSRR register of its port (the upper half of BSRR resets the pin)
+#define   LCD_WRITE_PIN(p, state)	(LCD_PIN_PORT(p)->BSRR = (uint32_t)LCD_PIN_MASK(p) << (((state) != GPIO_PIN_RESET) ? (0U) : (16U)))
+#else
+// sets or resets a pin of the LCD (a HD44780_LCD_Pin_t)
+#define   LCD_WRITE_PIN(p, state)	HAL_GPIO_WritePin(LCD_PIN_PORT(p), LCD_PIN_MASK(p), (GPIO_PinState)(state))
+#endif
+
+// the width (in microseconds) of the pulses on the EN pin, and of the gap after them (at least 450ns and 1us for the whole cycle on the HD44780)
+#ifndef   LCD_ENABLE_PULSE_US
+#define   LCD_ENABLE_PULSE_US	1
+#endif
+
+// flag of an entry of a sequence of instructions, which denotes that the entry is written to the Data Register
+#define   LCD_SEQ_DATA			0x100
+// flag of an entry of a sequence of instructions, which denotes that the entry is a function set whose bus size is filled in when it is sent
+#define   LCD_SEQ_FUNCTION		0x200
+
+// the size of the Character Generator RAM (8 glyphs of 8 rows each)
+#define   LCD_CGRAM_SIZE		0x40
+// the number of glyphs the Character Generator RAM holds
+#define   LCD_CGRAM_GLYPHS		8
+
+// the first and last characters of the built-in 5x8 font
+#define   LCD_FONT_FIRST		0x20
+#define   LCD_FONT_LAST			0x7E
+
+// the number of commands a command queue holds (a power of 2, at most 128)
+#ifndef   LCD_QUEUE_SIZE
+#define   LCD_QUEUE_SIZE		32
+#endif
+
+// the number of consecutive cells of a frame that share a dirty flag (a power of 2 that divides LCD_LINE_SIZE)
+#ifndef   LCD_FRAME_GROUP
+#define   LCD_FRAME_GROUP		8
+#endif
+// the number of dirty flags of a frame
+#define   LCD_FRAME_GROUPS		(2 * LCD_LINE_SIZE / LCD_FRAME_GROUP)
+
+// the most cells a canvas covers (each takes 8 bytes of pixels)
+#ifndef   LCD_CANVAS_MAX_CELLS
+#define   LCD_CANVAS_MAX_CELLS	16
+#endif
+// the character of the ROM whose pixels are all set (on the A00 and A02 ROMs)
+#ifndef   LCD_ROM_FULL_BLOCK
+#define   LCD_ROM_FULL_BLOCK	0xFF
+#endif
+
+// the most bars a level meter has
+#ifndef   LCD_METER_MAX_BARS
+#define   LCD_METER_MAX_BARS	16
+#endif
+
+// the character of the ROM shown in place of characters of UTF-8 text that neither the ROM nor the CGRAM can show
+#ifndef   LCD_UTF8_MISSING
+#define   LCD_UTF8_MISSING		'?'
+#endif
+// the size of the buffer that LCD_printf formats text into (on the stack)
+#ifndef   LCD_PRINTF_SIZE
+#define   LCD_PRINTF_SIZE		64
+#endif
+// the period (in microseconds) at which the words of a screen compiled for GPIO Pins are written to the BSRR register (e.g. by a timer that triggers DMA)
+#ifndef   LCD_SCREEN_TICK_US
+#define   LCD_SCREEN_TICK_US	10
+#endif
+
+// whether the library runs along with a CMSIS-RTOS2 kernel (e.g. FreeRTOS), which provides the display task and lets long waits sleep instead of busy-waiting (1)
+#ifndef   LCD_USE_CMSIS_RTOS2
+#define   LCD_USE_CMSIS_RTOS2	0
+#endif
+// the shortest wait (in microseconds) that sleeps instead of busy-waiting when called from a task while the kernel is running
+#ifndef   LCD_RTOS_SLEEP_US
+#define   LCD_RTOS_SLEEP_US		1000
+#endif
+// the number of requests the queue of the display task holds
+#ifndef   LCD_RTOS_QUEUE_LEN
+#define   LCD_RTOS_QUEUE_LEN	8
+#endif
+// the most characters carried by a single request (longer text is split into several requests)
+#ifndef   LCD_RTOS_TEXT_LEN
+#define   LCD_RTOS_TEXT_LEN		16
+#endif
+// the size (in bytes) of the stack of the display task
+#ifndef   LCD_RTOS_STACK_SIZE
+#define   LCD_RTOS_STACK_SIZE	512
+#endif
+// the priority of the display task
+#ifndef   LCD_RTOS_PRIORITY
+#define   LCD_RTOS_PRIORITY		osPriorityBelowNormal
+#endif
+// the thread flag set on a task waiting in LCD_requestSync once the display task has handled its earlier requests
+#ifndef   LCD_RTOS_SYNC_FLAG
+#define   LCD_RTOS_SYNC_FLAG	0x00010000U
+#endif
+
 enum HD44780_LCD_BUS_MODE {
-	halfBus, fullBus, shiftReg, I2C
+	halfBus, fullBus, shiftReg, I2C, SPI, custom
 };
 
-/** Structs ------------------------------------------------------------------*/
-typedef struct HD44780_LCD_t {
+// state of the link to an LCD driven via I2C (the states after offline re-attach a re-plugged LCD)
+enum HD44780_LCD_LINK {
+	linkOnline, linkOffline, linkPowerUp, linkWake1, linkWake2, linkWake3, linkConfigure, linkClear, linkReplay
+};
+
+// what is done with a command posted to a full command queue
+enum HD44780_LCD_QUEUE_POLICY {
+	queueDropNewest, queueDropOldest, queueCoalesce
+};
 
-	I2C_HandleTypeDef *I2CHandle;
-	uint32_t backlightMask;
-	uint32_t I2CAddr;
+// what a canvas shows in the cells whose glyphs do not fit in its locations of the CGRAM
+enum HD44780_LCD_CANVAS_FALLBACK {
+	canvasNearest, canvasThreshold
+};
 
-	GPIO_TypeDef *dataPort[8];
+// character ROM of the LCD, which the part number of the controller ends with (A00 is Japanese, A02 is European)
+enum HD44780_LCD_ROM {
+	romA00, romA02
+};
 
-	GPIO_TypeDef *enPort;
-	GPIO_TypeDef *rsPort;
+// what a track of a timeline animates
+enum HD44780_LCD_TRACK {
+	trackReveal, trackScroll, trackGlyph, trackBlink
+};
 
-	uint16_t dataPin[8];
+// how the stream of a compiled screen is replayed
+enum HD44780_LCD_SCREEN {
+	screenNone, screenI2C, screenGPIO
+};
 
-	uint32_t enPin :16;
-	uint32_t rsPin :16;
+/** Structs ------------------------------------------------------------------*/
+struct HD44780_LCD_t;
+
+typedef struct HD44780_LCD_Pin_t {
+	uint8_t port;		// index of the GPIO Port of the pin (0 for GPIOA, 1 for GPIOB and so on, LCD_PORT_NONE if not connected)
+	uint8_t pin;		// number of the pin within its GPIO Port (0 to 15)
+} HD44780_LCD_Pin_t;
+
+typedef struct HD44780_LCD_ExpanderPins_t {
+	uint8_t rs;			// index of the bit of the Expander's port that drives the RS pin of the LCD
+	uint8_t en;			// index of the bit of the Expander's port that drives the EN pin of the LCD
+	uint8_t backlight;	// index of the bit of the Expander's port that drives the backlight of the LCD
+	uint8_t data[4];	// indices of the bits of the Expander's port that drive pins D4-D7 of the LCD (only used by 4-bit Expanders)
+} HD44780_LCD_ExpanderPins_t;
+
+typedef struct HD44780_LCD_Variant_t {
+	uint16_t powerUpMs;			// time to wait after power-up before the first instruction (in milliseconds)
+	uint16_t wakeUs;			// time to wait after each function set of the wake sequence (in microseconds)
+	uint16_t clearUs;			// execution time of the clear display and return home instructions (in microseconds)
+	uint16_t execUs;			// execution time of every other instruction and of data writes (in microseconds)
+
+	uint8_t functionSet;		// bits ORed into every function set (e.g. the font table of the WS0010)
+	uint8_t doubleHeight;		// bit of the function set that enables double-height characters (0 if not supported)
+
+	uint8_t setupLen;			// number of entries in the setup sequence
+	uint8_t contrastLen;		// number of entries in the contrast sequence (0 if the contrast cannot be set)
+	uint8_t contrastPos;		// index of the entry of the contrast sequence that is replaced by the contrast
+	uint8_t defaultContrast;	// contrast the LCD is initialized with
+
+	const uint16_t *setup;		// sequence sent after the function set while initializing the LCD (entries may be flagged with LCD_SEQ_DATA or LCD_SEQ_FUNCTION)
+	const uint16_t *contrast;	// sequence that sets the contrast (the brightness of OLEDs)
+} HD44780_LCD_Variant_t;
+
+typedef struct HD44780_LCD_Transport_t {
+	uint8_t busSize;	// width of the bus between the transport and the LCD (LCD_BUS_SIZE_4 or LCD_BUS_SIZE_8)
+
+	// configures the transport to drive the LCD (called before initializing the LCD, including after it is re-attached)
+	HAL_StatusTypeDef (*configure)(struct HD44780_LCD_t *lcd);
+	// sends an instruction as a single transfer of the width of the bus (only the higher nibble for 4-bit transports), used while initializing the LCD
+	HAL_StatusTypeDef (*writeInit)(struct HD44780_LCD_t *lcd, uint8_t instruction);
+	// sends a sequence of instructions (isData = 0) or data (isData = 1) to the LCD, giving each byte the time the controller needs to execute it (except for clearing the display and returning home)
+	HAL_StatusTypeDef (*write)(struct HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData);
+	// updates the state of the backlight
+	HAL_StatusTypeDef (*writeBacklight)(struct HD44780_LCD_t *lcd);
+	// updates the contrast, for controllers that set it through their own instructions (NULL otherwise)
+	HAL_StatusTypeDef (*writeContrast)(struct HD44780_LCD_t *lcd);
+} HD44780_LCD_Transport_t;
+
+// I2C IO Expanders are transports, and are still referred to by their original name
+typedef HD44780_LCD_Transport_t HD44780_LCD_Expander_t;
+
+typedef struct HD44780_LCD_Shadow_t {
+#if LCD_USE_SHADOW
+	uint8_t ddram[2][LCD_LINE_SIZE];	// copy of the Display Data RAM (one row per line)
+	uint8_t cgram[LCD_CGRAM_SIZE];		// copy of the Character Generator RAM
+#endif
+	uint8_t addr;						// address counter of the LCD
+	uint8_t inCGRAM;					// whether the address counter points into the CGRAM (1) or DDRAM (0)
+	uint8_t shift;						// number of positions the display has been shifted left by (0 to LCD_LINE_SIZE-1)
+} HD44780_LCD_Shadow_t;
+
+typedef struct HD44780_LCD_I2CStats_t {
+	uint32_t nack;			// transfers that were not acknowledged by the I2C Expander
+	uint32_t timeout;		// transfers that did not complete within their timeout
+	uint32_t busError;		// transfers that failed due to a busy bus, bus error or lost arbitration
+	uint32_t retries;		// transfers that were re-attempted
+	uint32_t recoveries;	// bus recoveries that were performed
+	uint32_t dropped;		// transfers that were abandoned (failed after all retries, or skipped while offline)
+} HD44780_LCD_I2CStats_t;
 
-	uint32_t displayState :16;
-	uint32_t cursorMovement :16;
+typedef struct HD44780_LCD_t {
 
-	enum HD44780_LCD_BUS_MODE busMode;
+	const HD44780_LCD_Transport_t *transport;
+	void *transportContext;
+	const HD44780_LCD_Variant_t *variant;
+
+	HD44780_LCD_Shadow_t shadow;
+
+	uint8_t busMode;			// how the LCD is driven (one of HD44780_LCD_BUS_MODE)
+	uint8_t I2CLink;			// state of the link to the LCD (one of HD44780_LCD_LINK, always linkOnline unless the LCD is driven via I2C)
+	uint8_t displayState;
+	uint8_t cursorMovement;
+	uint8_t functionFlags;
+	uint8_t backlight;			// whether the backlight is on
+	uint8_t contrast;
+	uint8_t extState;
+
+	HD44780_LCD_Pin_t enPin;
+	HD44780_LCD_Pin_t rsPin;
+
+	// only the fields of the transport that drives the LCD are stored
+	union {
+#if LCD_USE_GPIO
+		struct {
+			HD44780_LCD_Pin_t dataPins[8];
+		};
+#endif
+#if LCD_USE_I2C
+		struct {
+			I2C_HandleTypeDef *I2CHandle;
+			uint32_t I2CLinkTick;
+			HD44780_LCD_I2CStats_t I2CStats;
+#if LCD_I2C_NIBBLE_TABLE
+			uint8_t I2CNibbles[2][16];
+#endif
+			HD44780_LCD_ExpanderPins_t expanderPins;
+			HD44780_LCD_Pin_t sclPin;
+			HD44780_LCD_Pin_t sdaPin;
+			uint8_t I2CAddr;
+			uint8_t backlightMask;
+			uint8_t I2CRetries;
+			uint8_t I2CFailures;
+			uint8_t I2CProbeOrdinal;
+			uint8_t I2CProbeIndex;
+			uint8_t I2CProbeFound;
+			uint8_t I2CReplayPos;
+			uint8_t I2CReplayDirty;
+		};
+#endif
+#if LCD_USE_SPI
+		struct {
+			SPI_HandleTypeDef *SPIHandle;
+			HD44780_LCD_Pin_t csPin;
+		};
+#endif
+	};
 } HD44780_LCD_t;
 
+typedef struct HD44780_LCD_QueueStats_t {
+	uint32_t posted;		// commands that were added to the queue
+	uint32_t executed;		// commands that were sent to the LCD
+	uint32_t dropped;		// commands that were discarded because the queue was full (the newest or the oldest, according to the policy)
+	uint32_t coalesced;		// commands that replaced a pending write to the same cell because the queue was full
+	uint32_t highWater;		// largest number of commands that were pending at once
+} HD44780_LCD_QueueStats_t;
+
+typedef struct HD44780_LCD_Queue_t {
+	HD44780_LCD_t *lcd;								// LCD that the commands are sent to
+	volatile uint32_t cmds[LCD_QUEUE_SIZE];			// encoded commands (each is a single word, so it is posted and taken with one access)
+	volatile uint8_t head;							// number of commands posted (written only by the producer, wraps around)
+	volatile uint8_t tail;							// number of commands taken (written by the consumer, and by the producer while dropping the oldest command)
+	volatile uint8_t taking;						// whether the consumer is taking a command, during which the producer leaves the oldest command alone
+	uint8_t policy;									// what is done with a command posted to a full queue (one of HD44780_LCD_QUEUE_POLICY)
+	HD44780_LCD_QueueStats_t stats;					// statistics of the queue (executed is written by the consumer, the rest by the producer)
+} HD44780_LCD_Queue_t;
+
+typedef struct HD44780_LCD_Frame_t {
+	HD44780_LCD_t *lcd;								// LCD that the frame is flushed to
+	volatile uint8_t cells[2][LCD_LINE_SIZE];		// contents the DDRAM should have (one row per line)
+	volatile uint8_t dirty[LCD_FRAME_GROUPS];		// whether each group of LCD_FRAME_GROUP cells was written since it was last flushed
+	volatile uint8_t pending;						// whether any group was written since the frame was last flushed
+} HD44780_LCD_Frame_t;
+
+typedef struct HD44780_LCD_Track_t {
+	struct HD44780_LCD_Track_t *next;				// next track of the timeline the track runs on
+	const uint8_t *data;							// text of a reveal or blink track, frames (8 rows each) of a glyph track
+	uint32_t period;								// number of ticks between steps
+	uint32_t due;									// tick at which the next step is due
+	uint16_t step;									// number of steps taken since the track was started
+	uint16_t steps;									// number of steps after which the track ends (0 to repeat forever)
+	uint8_t kind;									// what the track animates (one of HD44780_LCD_TRACK)
+	uint8_t arg;									// direction of a scroll track (0 for left, 1 for right), location of a glyph track
+	uint8_t row;									// row of the text of a reveal or blink track
+	uint8_t col;									// column of the first character of a reveal or blink track
+	uint8_t len;									// number of characters of a reveal or blink track, number of frames of a glyph track
+	uint8_t running;								// whether the track is on a timeline
+} HD44780_LCD_Track_t;
+
+typedef struct HD44780_LCD_Timeline_t {
+	HD44780_LCD_t *lcd;								// LCD that the tracks are animated on
+	HD44780_LCD_Track_t *tracks;					// first track of the timeline (NULL if none is running)
+	uint32_t nextDue;								// tick at which the earliest track is due, before which LCD_tick returns at once
+} HD44780_LCD_Timeline_t;
+
+typedef struct HD44780_LCD_Marquee_t {
+	HD44780_LCD_t *lcd;								// LCD that the marquee scrolls
+	const uint8_t *text;							// text of the marquee, which is looped
+	uint16_t len;									// number of characters of the text
+	uint16_t period;								// number of characters after which the text repeats (shorter text is padded with spaces to LCD_LINE_SIZE)
+	uint16_t pos;									// index of the character shown in the left-most visible column
+	uint8_t row;									// row of the marquee
+} HD44780_LCD_Marquee_t;
+
+typedef struct HD44780_LCD_SmoothMarquee_t {
+	HD44780_LCD_t *lcd;								// LCD that the marquee scrolls
+	const uint8_t *text;							// text of the marquee, which is looped
+	uint16_t len;									// number of characters of the text
+	uint16_t pos;									// pixel column of the text shown in the left-most pixel column of the segment
+	uint8_t row;									// row of the segment
+	uint8_t col;									// column of the first cell of the segment
+	uint8_t width;									// number of cells of the segment
+	uint8_t firstLoc;								// location of the glyph of the first cell (cell i uses location firstLoc + i)
+} HD44780_LCD_SmoothMarquee_t;
+
+typedef struct HD44780_LCD_Canvas_t {
+	HD44780_LCD_t *lcd;								// LCD that the canvas is drawn on
+	uint8_t pixels[LCD_CANVAS_MAX_CELLS][8];		// rows of the pixels of each cell, row by row (bit 4 of a row is its left-most pixel)
+	uint8_t row;									// row of the top-left cell
+	uint8_t col;									// column of the top-left cell
+	uint8_t rows;									// number of rows of cells (1 or 2)
+	uint8_t cols;									// number of columns of cells
+	uint8_t firstLoc;								// first location of the CGRAM the canvas may use
+	uint8_t locs;									// number of locations of the CGRAM the canvas may use
+	uint8_t fallback;								// what is shown in cells whose glyphs do not fit (one of HD44780_LCD_CANVAS_FALLBACK)
+	uint8_t dirty;									// whether the canvas was drawn on since it was last flushed
+} HD44780_LCD_Canvas_t;
+
+typedef struct HD44780_LCD_GlyphCache_t {
+	HD44780_LCD_t *lcd;								// LCD whose CGRAM the cache manages
+	uint8_t refs[LCD_CGRAM_GLYPHS];					// number of users holding each location (0 if the location is free)
+	uint16_t released[LCD_CGRAM_GLYPHS];			// value of the clock when each location was last released
+	uint16_t clock;									// number of locations that were released, which orders the free locations
+	uint8_t firstLoc;								// first location of the CGRAM the cache manages
+	uint8_t locs;									// number of locations of the CGRAM the cache manages
+#if !LCD_USE_SHADOW
+	uint8_t loaded;									// locations the cache has loaded a glyph into (bit i for location i)
+	uint8_t glyphs[LCD_CGRAM_GLYPHS][8];			// rows of the glyph each location was loaded with, as there is no shadow buffer to compare with
+#endif
+} HD44780_LCD_GlyphCache_t;
+
+typedef struct HD44780_LCD_Bar_t {
+	HD44780_LCD_GlyphCache_t *cache;				// glyph cache holding the glyphs of the partly filled cells
+	uint8_t locs[4];								// locations of the glyphs with 1 to 4 left-most columns set
+	uint16_t level;									// number of pixel columns that are filled
+	uint8_t row;									// row of the bar
+	uint8_t col;									// column of the first cell of the bar
+	uint8_t width;									// number of cells of the bar
+} HD44780_LCD_Bar_t;
+
+typedef struct HD44780_LCD_Meter_t {
+	HD44780_LCD_GlyphCache_t *cache;				// glyph cache holding the glyphs of the partly filled cells
+	uint8_t locs[7];								// locations of the glyphs with 1 to 7 bottom rows set
+	uint8_t shown[LCD_METER_MAX_BARS];				// level each bar shows, in pixel rows
+	uint8_t hold[LCD_METER_MAX_BARS];				// number of frames before each bar that is above its level falls by one pixel row
+	uint8_t row;									// row of the top cells of the bars
+	uint8_t col;									// column of the first bar
+	uint8_t bars;									// number of bars
+	uint8_t rows;									// number of cells of each bar (1 or 2)
+	uint8_t decay;									// number of frames after which a bar above its level falls by one pixel row (0 to always show the level)
+	uint8_t next;									// cell the next flush starts from (cells are numbered row by row)
+} HD44780_LCD_Meter_t;
+
+typedef struct HD44780_LCD_BigFont_t {
+	const uint8_t (*glyphs)[8];						// glyphs of the font, loaded into consecutive locations of the CGRAM
+	const uint8_t *digits;							// cells of the digits 0 to 9, 2 * width each, the top row followed by the bottom row
+	uint8_t colon[2];								// cells of ':' (top and bottom)
+	uint8_t dot[2];									// cells of '.' (top and bottom)
+	uint8_t count;									// number of glyphs (at most LCD_CGRAM_GLYPHS)
+	uint8_t width;									// number of columns of a digit
+	uint8_t spacing;								// number of blank columns between two digits
+} HD44780_LCD_BigFont_t;
+
+typedef struct HD44780_LCD_BigDigits_t {
+	HD44780_LCD_t *lcd;								// LCD that the digits are drawn on
+	const HD44780_LCD_BigFont_t *font;				// font of the digits (cells below LCD_CGRAM_GLYPHS are its glyphs, the rest characters of the ROM)
+	uint8_t col;									// column of the left-most cell
+	uint8_t firstLoc;								// location of the first glyph of the font
+	uint8_t end;									// column after the last cell of the text drawn last
+} HD44780_LCD_BigDigits_t;
+
+typedef struct HD44780_LCD_Text_t {
+	HD44780_LCD_t *lcd;								// LCD that the text is written to
+	HD44780_LCD_GlyphCache_t *cache;				// glyph cache that characters missing from the ROM are drawn into (NULL if they are not)
+	uint32_t codePoint;								// bits of the character being decoded
+	uint8_t rom;									// character ROM of the LCD (one of HD44780_LCD_ROM)
+	uint8_t pending;								// number of continuation bytes still expected by the character being decoded
+	uint8_t length;									// number of continuation bytes of the character being decoded
+	uint8_t held;									// locations of the CGRAM that the text holds (bit i for location i)
+} HD44780_LCD_Text_t;
+
+typedef struct HD44780_LCD_Screen_t {
+	HD44780_LCD_t *lcd;								// LCD that the screen is shown on
+	const uint8_t *cells;							// codes of the cells, LCD_VISIBLE_COLS of the first row followed by those of the second
+	const void *stream;								// compiled stream (I2C frames as bytes, or BSRR words for GPIO Pins)
+	void *buf;										// buffer the stream is compiled into (NULL if it was compiled at build time)
+	uint32_t size;									// size of the buffer in bytes
+	uint32_t len;									// length of the stream in bytes
+	uint8_t kind;									// how the stream is replayed (one of HD44780_LCD_SCREEN)
+} HD44780_LCD_Screen_t;
+
+typedef struct HD44780_LCD_Pages_t {
+	HD44780_LCD_t *lcd;								// LCD whose DDRAM holds the pages
+	uint8_t front;									// page that is visible (page p occupies columns p*LCD_VISIBLE_COLS to (p+1)*LCD_VISIBLE_COLS-1 of both lines)
+} HD44780_LCD_Pages_t;
+
+#if LCD_USE_CMSIS_RTOS2
+typedef struct HD44780_LCD_Service_t {
+	HD44780_LCD_t *lcd;								// LCD owned by the display task
+	osThreadId_t thread;							// display task
+	osMessageQueueId_t queue;						// requests to the display task
+	HAL_StatusTypeDef initStatus;					// status of the initialization of the LCD by the display task
+} HD44780_LCD_Service_t;
+#endif
+
+/** Transports ---------------------------------------------------------------*/
+#if LCD_USE_GPIO
+extern const HD44780_LCD_Transport_t LCD_GPIO_HALF_BUS;
+extern const HD44780_LCD_Transport_t LCD_GPIO_FULL_BUS;
+extern const HD44780_LCD_Transport_t LCD_SHIFT_REGISTER;
+#endif
+#if LCD_USE_I2C
+extern const HD44780_LCD_Transport_t LCD_PCF8574;
+extern const HD44780_LCD_Transport_t LCD_MCP23008;
+extern const HD44780_LCD_Transport_t LCD_MCP23017;
+extern const HD44780_LCD_Transport_t LCD_ST7032;
+extern const HD44780_LCD_Transport_t LCD_AIP31068;
+extern const HD44780_LCD_Transport_t LCD_US2066;
+#endif
+#if LCD_USE_SPI
+extern const HD44780_LCD_Transport_t LCD_ST7032_SPI;
+extern const HD44780_LCD_Transport_t LCD_WS0010_SPI;
+#endif
+
+/** Variants -----------------------------------------------------------------*/
+extern const HD44780_LCD_Variant_t LCD_VARIANT_HD44780;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_KS0066;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_ST7066U;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_SPLC780D;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_ST7032;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_US2066;
+extern const HD44780_LCD_Variant_t LCD_VARIANT_WS0010;
+
+/** Big Fonts ----------------------------------------------------------------*/
+extern const HD44780_LCD_BigFont_t LCD_BIG_FONT_3X2;
+
 /** Functions ----------------------------------------------------------------*/
+#if LCD_USE_GPIO
 void LCD_createHalfBus(HD44780_LCD_t *lcd, GPIO_TypeDef *port0, uint16_t pin0,
 		GPIO_TypeDef *port1, uint16_t pin1, GPIO_TypeDef *port2, uint16_t pin2,
 		GPIO_TypeDef *port3, uint16_t pin3, GPIO_TypeDef *enPort,
@@ -144,22 +731,82 @@ void LCD_createShiftRegister(HD44780_LCD_t *lcd, GPIO_TypeDef *dataPort,
 		uint16_t dataPin, GPIO_TypeDef *clockPort, uint16_t clockPin,
 		GPIO_TypeDef *latchPort, uint16_t latchPin, GPIO_TypeDef *enPort,
 		uint16_t enPin, GPIO_TypeDef *rsPort, uint16_t rsPin);
+#endif
+#if LCD_USE_I2C
 void LCD_createI2C(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle);
 void LCD_createI2C_addr(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr);
-
-void LCD_init(HD44780_LCD_t *lcd);
-
-void LCD_sendNibble(HD44780_LCD_t *lcd, uint8_t nibble);
-void LCD_sendByte(HD44780_LCD_t *lcd, uint8_t byte);
-void LCD_shiftByte(HD44780_LCD_t *lcd, uint8_t byte);
-void LCD_sendNibble_I2C(HD44780_LCD_t *lcd, uint8_t nibble);
-void LCD_sendInstruction(HD44780_LCD_t *lcd, uint8_t instruction);
-void LCD_sendData(HD44780_LCD_t *lcd, const uint8_t data);
-void LCD_sendBuffer(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len);
-
-void LCD_enableBacklight(HD44780_LCD_t *lcd);
-void LCD_disableBacklight(HD44780_LCD_t *lcd);
-void LCD_toggleBacklight(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_createI2C_probe(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t ordinal);
+HAL_StatusTypeDef LCD_probeI2C(I2C_HandleTypeDef *I2CHandle, uint8_t ordinal, uint8_t *lcdAddr);
+void LCD_createI2C_pins(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins);
+void LCD_createMCP23008(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins);
+void LCD_createMCP23017(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins);
+
+void LCD_createST7032(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr);
+void LCD_createAiP31068(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr);
+void LCD_createUS2066(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr);
+#endif
+#if LCD_USE_SPI
+void LCD_createST7032_SPI(HD44780_LCD_t *lcd, SPI_HandleTypeDef *SPIHandle,
+		GPIO_TypeDef *csPort, uint16_t csPin, GPIO_TypeDef *rsPort, uint16_t rsPin);
+void LCD_createWS0010_SPI(HD44780_LCD_t *lcd, SPI_HandleTypeDef *SPIHandle,
+		GPIO_TypeDef *csPort, uint16_t csPin);
+#endif
+void LCD_createTransport(HD44780_LCD_t *lcd, const HD44780_LCD_Transport_t *transport, void *context);
+void LCD_setVariant(HD44780_LCD_t *lcd, const HD44780_LCD_Variant_t *variant);
+HD44780_LCD_Pin_t LCD_encodePin(GPIO_TypeDef *port, uint16_t pin);
+
+#if LCD_USE_I2C
+void LCD_setI2CPins(HD44780_LCD_t *lcd, const HD44780_LCD_ExpanderPins_t *pins);
+void LCD_setI2CRecoveryPins(HD44780_LCD_t *lcd, GPIO_TypeDef *sclPort,
+		uint16_t sclPin, GPIO_TypeDef *sdaPort, uint16_t sdaPin);
+void LCD_setI2CRetries(HD44780_LCD_t *lcd, uint8_t retries);
+HAL_StatusTypeDef LCD_recoverI2C(HD44780_LCD_t *lcd);
+const HD44780_LCD_I2CStats_t *LCD_getI2CStats(const HD44780_LCD_t *lcd);
+void LCD_resetI2CStats(HD44780_LCD_t *lcd);
+void LCD_serviceI2C(HD44780_LCD_t *lcd);
+#endif
+uint8_t LCD_isOnline(const HD44780_LCD_t *lcd);
+
+HAL_StatusTypeDef LCD_init(HD44780_LCD_t *lcd);
+
+#if LCD_USE_GPIO
+HAL_StatusTypeDef LCD_sendNibble(HD44780_LCD_t *lcd, uint8_t nibble);
+HAL_StatusTypeDef LCD_sendByte(HD44780_LCD_t *lcd, uint8_t byte);
+HAL_StatusTypeDef LCD_shiftByte(HD44780_LCD_t *lcd, uint8_t byte);
+#endif
+#if LCD_USE_I2C
+HAL_StatusTypeDef LCD_sendNibbleI2C(HD44780_LCD_t *lcd, uint8_t nibble, uint8_t isData);
+HAL_StatusTypeDef LCD_transmitI2C(HD44780_LCD_t *lcd, uint8_t *buf, uint16_t len);
+uint8_t LCD_encodeI2CNibble(const HD44780_LCD_t *lcd, uint8_t isData, uint8_t nibble);
+void LCD_encodeI2CNibbles(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_sendFramesI2C(HD44780_LCD_t *lcd, const uint8_t *frames, const uint8_t *data, uint32_t len);
+#endif
+void LCD_delayUs(uint32_t us);
+HAL_StatusTypeDef LCD_configureNone(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_writeBacklightNone(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_sendInstruction(HD44780_LCD_t *lcd, uint8_t instruction);
+HAL_StatusTypeDef LCD_startInstruction(HD44780_LCD_t *lcd, uint8_t instruction, uint32_t *execUs);
+HAL_StatusTypeDef LCD_sendData(HD44780_LCD_t *lcd, const uint8_t data);
+HAL_StatusTypeDef LCD_sendBuffer(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len);
+HAL_StatusTypeDef LCD_sendInstructions(HD44780_LCD_t *lcd, const uint8_t *buf, const uint32_t len);
+HAL_StatusTypeDef LCD_sendSequence(HD44780_LCD_t *lcd, const uint16_t *seq, uint32_t len);
+void LCD_trackTransfer(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData);
+
+HAL_StatusTypeDef LCD_enableBacklight(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_disableBacklight(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_toggleBacklight(HD44780_LCD_t *lcd);
+
+HAL_StatusTypeDef LCD_setContrast(HD44780_LCD_t *lcd, uint8_t contrast);
+HAL_StatusTypeDef LCD_enableDoubleHeight(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_disableDoubleHeight(HD44780_LCD_t *lcd);
+#if LCD_USE_I2C || LCD_USE_SPI
+HAL_StatusTypeDef LCD_enableIcons(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_disableIcons(HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_setIcons(HD44780_LCD_t *lcd, uint8_t addr, uint8_t icons);
+#endif
 
 void LCD_setCursorAutoDec(HD44780_LCD_t *lcd);
 void LCD_setCursorAutoInc(HD44780_LCD_t *lcd);
@@ -185,6 +832,100 @@ void LCD_moveCursorLeft(HD44780_LCD_t *lcd);
 void LCD_moveCursorRight(HD44780_LCD_t *lcd);
 void LCD_scrollDisplayLeft(HD44780_LCD_t *lcd);
 void LCD_scrollDisplayRight(HD44780_LCD_t *lcd);
-void LCD_createCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t ar[8]);
+HAL_StatusTypeDef LCD_createCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t ar[8]);
+HAL_StatusTypeDef LCD_updateCustomChar(HD44780_LCD_t *lcd, const uint32_t loc, const uint8_t glyph[8]);
+
+const uint8_t *LCD_fontColumns(uint8_t ch);
+void LCD_fontGlyph(uint8_t ch, uint8_t glyph[8]);
+const uint8_t *LCD_fontCodePoint(uint32_t codePoint);
+uint8_t LCD_fontCodePointGlyph(uint32_t codePoint, uint8_t glyph[8]);
+
+uint8_t LCD_romCode(enum HD44780_LCD_ROM rom, uint32_t codePoint);
+void LCD_initText(HD44780_LCD_Text_t *text, HD44780_LCD_t *lcd, enum HD44780_LCD_ROM rom, HD44780_LCD_GlyphCache_t *cache);
+uint8_t LCD_decodeUTF8(HD44780_LCD_Text_t *text, uint8_t byte, uint32_t *codePoint);
+HAL_StatusTypeDef LCD_sendUTF8(HD44780_LCD_Text_t *text, const char *buf, uint32_t len);
+HAL_StatusTypeDef LCD_printf(HD44780_LCD_Text_t *text, const char *format, ...);
+void LCD_releaseText(HD44780_LCD_Text_t *text);
+
+void LCD_initQueue(HD44780_LCD_Queue_t *queue, HD44780_LCD_t *lcd, enum HD44780_LCD_QUEUE_POLICY policy);
+HAL_StatusTypeDef LCD_postInstruction(HD44780_LCD_Queue_t *queue, uint8_t instruction);
+HAL_StatusTypeDef LCD_postData(HD44780_LCD_Queue_t *queue, uint8_t data);
+HAL_StatusTypeDef LCD_postCell(HD44780_LCD_Queue_t *queue, uint8_t row, uint8_t col, uint8_t data);
+HAL_StatusTypeDef LCD_postField(HD44780_LCD_Queue_t *queue, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len);
+uint32_t LCD_drainQueue(HD44780_LCD_Queue_t *queue, uint32_t max);
+const HD44780_LCD_QueueStats_t *LCD_getQueueStats(const HD44780_LCD_Queue_t *queue);
+
+void LCD_initFrame(HD44780_LCD_Frame_t *frame, HD44780_LCD_t *lcd);
+void LCD_writeCell(HD44780_LCD_Frame_t *frame, uint8_t row, uint8_t col, uint8_t data);
+void LCD_writeCells(HD44780_LCD_Frame_t *frame, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len);
+uint32_t LCD_flushFrame(HD44780_LCD_Frame_t *frame, uint32_t max);
+
+void LCD_initTimeline(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_t *lcd);
+void LCD_initRevealTrack(HD44780_LCD_Track_t *track, uint8_t row, uint8_t col, const uint8_t *text, uint8_t len, uint32_t period);
+void LCD_initScrollTrack(HD44780_LCD_Track_t *track, uint8_t right, uint16_t steps, uint32_t period);
+void LCD_initGlyphTrack(HD44780_LCD_Track_t *track, uint8_t loc, const uint8_t (*frames)[8], uint8_t count, uint32_t period);
+void LCD_initBlinkTrack(HD44780_LCD_Track_t *track, uint8_t row, uint8_t col, const uint8_t *text, uint8_t len, uint32_t period);
+void LCD_startTrack(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_Track_t *track, uint32_t now);
+void LCD_stopTrack(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_Track_t *track);
+uint32_t LCD_tick(HD44780_LCD_Timeline_t *timeline, uint32_t now);
+
+HAL_StatusTypeDef LCD_initMarquee(HD44780_LCD_Marquee_t *marquee, HD44780_LCD_t *lcd, uint8_t row, const uint8_t *text, uint16_t len);
+HAL_StatusTypeDef LCD_stepMarquee(HD44780_LCD_Marquee_t *marquee);
+HAL_StatusTypeDef LCD_initSmoothMarquee(HD44780_LCD_SmoothMarquee_t *marquee, HD44780_LCD_t *lcd, uint8_t row, uint8_t col, uint8_t width,
+		uint8_t firstLoc, const uint8_t *text, uint16_t len);
+HAL_StatusTypeDef LCD_stepSmoothMarquee(HD44780_LCD_SmoothMarquee_t *marquee);
+
+HAL_StatusTypeDef LCD_initCanvas(HD44780_LCD_Canvas_t *canvas, HD44780_LCD_t *lcd, uint8_t row, uint8_t col, uint8_t rows, uint8_t cols,
+		uint8_t firstLoc, uint8_t locs, enum HD44780_LCD_CANVAS_FALLBACK fallback);
+void LCD_clearCanvas(HD44780_LCD_Canvas_t *canvas);
+void LCD_setPixel(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, uint8_t on);
+void LCD_drawLine(HD44780_LCD_Canvas_t *canvas, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t on);
+void LCD_drawRect(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, int32_t w, int32_t h, uint8_t on, uint8_t fill);
+void LCD_blitCanvas(HD44780_LCD_Canvas_t *canvas, int32_t x, int32_t y, const uint8_t *bitmap, uint32_t w, uint32_t h);
+HAL_StatusTypeDef LCD_flushCanvas(HD44780_LCD_Canvas_t *canvas);
+
+HAL_StatusTypeDef LCD_initGlyphCache(HD44780_LCD_GlyphCache_t *cache, HD44780_LCD_t *lcd, uint8_t firstLoc, uint8_t locs);
+HAL_StatusTypeDef LCD_acquireGlyph(HD44780_LCD_GlyphCache_t *cache, const uint8_t glyph[8], uint8_t *loc);
+void LCD_releaseGlyph(HD44780_LCD_GlyphCache_t *cache, uint8_t loc);
+
+HAL_StatusTypeDef LCD_initBar(HD44780_LCD_Bar_t *bar, HD44780_LCD_GlyphCache_t *cache, uint8_t row, uint8_t col, uint8_t width);
+HAL_StatusTypeDef LCD_setBar(HD44780_LCD_Bar_t *bar, uint16_t level);
+void LCD_releaseBar(HD44780_LCD_Bar_t *bar);
+
+HAL_StatusTypeDef LCD_initMeter(HD44780_LCD_Meter_t *meter, HD44780_LCD_GlyphCache_t *cache, uint8_t row, uint8_t col, uint8_t bars,
+		uint8_t rows, uint8_t decay);
+void LCD_setMeter(HD44780_LCD_Meter_t *meter, const uint8_t *levels);
+uint32_t LCD_flushMeter(HD44780_LCD_Meter_t *meter, uint32_t max);
+void LCD_releaseMeter(HD44780_LCD_Meter_t *meter);
+
+HAL_StatusTypeDef LCD_loadBigFont(HD44780_LCD_t *lcd, const HD44780_LCD_BigFont_t *font, uint8_t firstLoc);
+HAL_StatusTypeDef LCD_initBigDigits(HD44780_LCD_BigDigits_t *big, HD44780_LCD_t *lcd, const HD44780_LCD_BigFont_t *font, uint8_t col,
+		uint8_t firstLoc);
+HAL_StatusTypeDef LCD_drawBigDigits(HD44780_LCD_BigDigits_t *big, const char *text);
+
+uint32_t LCD_screenSize(const HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_compileScreen(HD44780_LCD_Screen_t *screen, HD44780_LCD_t *lcd, const uint8_t *cells, void *buf, uint32_t size);
+void LCD_initCompiledScreen(HD44780_LCD_Screen_t *screen, HD44780_LCD_t *lcd, const uint8_t *cells, const uint8_t *stream, uint32_t len);
+HAL_StatusTypeDef LCD_prepareScreen(HD44780_LCD_Screen_t *screen);
+HAL_StatusTypeDef LCD_showScreen(HD44780_LCD_Screen_t *screen);
+void LCD_trackScreen(HD44780_LCD_Screen_t *screen);
+
+HAL_StatusTypeDef LCD_initPages(HD44780_LCD_Pages_t *pages, HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_drawPage(HD44780_LCD_Pages_t *pages, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len);
+HAL_StatusTypeDef LCD_flipPages(HD44780_LCD_Pages_t *pages);
+
+#if LCD_USE_CMSIS_RTOS2
+HAL_StatusTypeDef LCD_startService(HD44780_LCD_Service_t *service, HD44780_LCD_t *lcd);
+HAL_StatusTypeDef LCD_requestInstruction(HD44780_LCD_Service_t *service, uint8_t instruction, uint32_t timeout);
+HAL_StatusTypeDef LCD_requestText(HD44780_LCD_Service_t *service, uint8_t row, uint8_t col,
+		const uint8_t *buf, uint32_t len, uint32_t timeout);
+HAL_StatusTypeDef LCD_requestCall(HD44780_LCD_Service_t *service, void (*fn)(HD44780_LCD_t *lcd, void *arg),
+		void *arg, uint32_t timeout);
+HAL_StatusTypeDef LCD_requestSync(HD44780_LCD_Service_t *service, uint32_t timeout);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* HD44780_LCD_H_ */
@@ -0,0 +1,594 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_LCD.hpp
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the C++20 coroutine front end of the library, whose display operations are awaited instead of blocking the core
+ ******************************************************************************
+ */
+
+#ifndef HD44780_LCD_HPP_
+#define HD44780_LCD_HPP_
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+#include "HD44780_Encode.hpp"
+
+// the number of coroutine frames the arena holds, i.e. the most coroutines started with hd44780::Task that run at the same time
+#ifndef   LCD_CORO_SLOTS
+#define   LCD_CORO_SLOTS		4
+#endif
+// the size (in bytes) of each frame of the arena (coroutines with larger frames fail to start)
+#ifndef   LCD_CORO_SLOT_SIZE
+#define   LCD_CORO_SLOT_SIZE	256
+#endif
+// the number of coroutines that can be suspended on an operation at the same time (operations awaited beyond it complete by blocking)
+#ifndef   LCD_CORO_WAITERS
+#define   LCD_CORO_WAITERS		4
+#endif
+// the most cells of a frame sent each time a coroutine awaiting a flush is polled
+#ifndef   LCD_CORO_FLUSH_CHUNK
+#define   LCD_CORO_FLUSH_CHUNK	8
+#endif
+
+namespace hd44780 {
+
+// statistics of the coroutine front end, used to size the arena and measure its overhead
+struct Stats {
+	std::size_t largestFrame;		// size of the largest coroutine frame requested from the arena
+	uint32_t framesInUse;			// number of frames of the arena currently in use
+	uint32_t allocFailures;			// number of coroutines that failed to start because the arena was full or their frame too large
+	uint32_t resumes;				// number of coroutines resumed by hd44780::poll
+	uint32_t blockingWaits;			// number of operations that completed by blocking because every waiter was in use
+};
+
+class Op;
+
+namespace detail {
+
+// coroutine frames are taken from a static arena of fixed-size slots, so the front end never uses the heap
+struct Arena {
+	alignas(std::max_align_t) unsigned char slots[LCD_CORO_SLOTS][LCD_CORO_SLOT_SIZE];
+	uint8_t used[LCD_CORO_SLOTS];
+};
+
+// coroutine suspended on an operation, which hd44780::poll resumes once the operation completes
+struct Waiter {
+	std::coroutine_handle<> handle;
+	Op *op;
+};
+
+inline Arena arena;
+inline Waiter waiters[LCD_CORO_WAITERS];
+inline Stats stats;
+
+/**
+ * @brief							Takes a slot of the arena for a coroutine frame
+ *
+ * @param		size				Size of the frame
+ *
+ * @return							Pointer to the slot, nullptr if the frame is too large or every slot is in use
+ */
+inline void *allocFrame(std::size_t size) noexcept {
+	if (size > stats.largestFrame) {
+		stats.largestFrame = size;
+	}
+
+	if (size <= LCD_CORO_SLOT_SIZE) {
+		for (uint32_t i = 0; i < LCD_CORO_SLOTS; ++i) {
+			if (!arena.used[i]) {
+				arena.used[i] = 1;
+				++stats.framesInUse;
+				return arena.slots[i];
+			}
+		}
+	}
+
+	++stats.allocFailures;
+	return nullptr;
+}
+
+/**
+ * @brief							Returns the slot of a coroutine frame to the arena
+ *
+ * @param		frame				Pointer to the frame
+ */
+inline void freeFrame(void *frame) noexcept {
+	const std::size_t i = (static_cast<unsigned char *>(frame) - &arena.slots[0][0]) / LCD_CORO_SLOT_SIZE;
+
+	arena.used[i] = 0;
+	--stats.framesInUse;
+}
+
+} // namespace detail
+
+/**
+ * @brief							Coroutine started by calling it, which runs until its first wait and is then resumed by hd44780::poll
+ *
+ * The frame of the coroutine is taken from the arena and returned to it once the coroutine finishes. A coroutine is never awaited by another, and
+ * since the library is built without exceptions, a Task must not throw
+ */
+class Task {
+public:
+	struct promise_type {
+		static void *operator new(std::size_t size) noexcept {
+			return detail::allocFrame(size);
+		}
+		static void operator delete(void *frame) noexcept {
+			detail::freeFrame(frame);
+		}
+
+		// a coroutine whose frame could not be taken from the arena is never started
+		static Task get_return_object_on_allocation_failure() noexcept {
+			return Task(false);
+		}
+		Task get_return_object() noexcept {
+			return Task(true);
+		}
+
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+		void return_void() noexcept {
+		}
+		void unhandled_exception() noexcept {
+		}
+	};
+
+	/**
+	 * @brief						Returns whether the coroutine was started
+	 *
+	 * @return						true if the coroutine was started, false if its frame could not be taken from the arena
+	 */
+	bool started() const noexcept {
+		return isStarted;
+	}
+
+private:
+	explicit Task(bool started) noexcept : isStarted(started) {
+	}
+
+	bool isStarted;
+};
+
+/**
+ * @brief							Operation of the LCD awaited by a coroutine, which completes once a deadline passes or a frame is flushed
+ *
+ * Transfers to the LCD are made by the C driver, whose transports complete them before returning, so an operation that only transfers completes
+ * immediately and its coroutine is not suspended. The waits that would otherwise busy-wait (clearing the display, returning home and sleeping) and
+ * flushes suspend the coroutine until hd44780::poll finds them complete. Awaiting an operation returns the status of its transfers
+ *
+ * While the LCD is executing an instruction that a suspended coroutine is waiting for (clearing the display or returning home), the operations of
+ * other coroutines on the same LCD suspend before making their transfers, and make them once the instruction has been executed
+ */
+class [[nodiscard]] Op {
+public:
+	/**
+	 * @brief						Creates an operation that has already completed
+	 *
+	 * @param		status			Status of the transfers of the operation
+	 */
+	explicit Op(HAL_StatusTypeDef status) noexcept : lcd(nullptr), data(nullptr), due(0), us(0), arg(0), status(status), kind(Kind::done) {
+	}
+
+	/**
+	 * @brief						Creates an operation that completes once a number of microseconds have passed
+	 *
+	 * @param		status			Status of the transfers of the operation
+	 * @param		us				Number of microseconds to wait for
+	 */
+	Op(HAL_StatusTypeDef status, uint32_t us) noexcept : lcd(nullptr), data(nullptr), due(0), us(0), arg(0), status(status), kind(Kind::done) {
+		wait(us);
+	}
+
+	/**
+	 * @brief						Creates an operation that completes once a frame has been flushed
+	 *
+	 * @param		frame			Pointer to the frame
+	 */
+	explicit Op(HD44780_LCD_Frame_t *frame) noexcept : lcd(frame->lcd), data(frame), due(0), us(0), arg(0), status(HAL_OK), kind(Kind::flush) {
+	}
+
+	bool await_ready() noexcept {
+		return poll(HAL_GetTick());
+	}
+
+	/**
+	 * @brief						Suspends the coroutine until hd44780::poll finds the operation complete, or completes it by blocking if every waiter is in use
+	 *
+	 * @param		handle			Handle of the awaiting coroutine
+	 *
+	 * @return						true if the coroutine was suspended, false if the operation completed by blocking
+	 */
+	bool await_suspend(std::coroutine_handle<> handle) noexcept {
+		for (detail::Waiter &waiter : detail::waiters) {
+			if (!waiter.handle) {
+				waiter.handle = handle;
+				waiter.op = this;
+				return true;
+			}
+		}
+
+		++detail::stats.blockingWaits;
+		if (kind == Kind::pending) {
+			while (isBusy(lcd, HAL_GetTick())) {
+			}
+			start();
+		}
+		if (kind == Kind::flush) {
+			while (LCD_flushFrame(frame(), LCD_LINE_SIZE * 2) != 0) {
+			}
+		} else if (kind == Kind::timed) {
+			LCD_delayUs(us);
+		}
+
+		return false;
+	}
+
+	HAL_StatusTypeDef await_resume() const noexcept {
+		return static_cast<HAL_StatusTypeDef>(status);
+	}
+
+	/**
+	 * @brief						Advances the operation, which makes its transfer once the LCD is free, then sends the next cells of a frame being flushed
+	 *
+	 * @param		now				Current tick
+	 *
+	 * @return						true if the operation is complete
+	 */
+	bool poll(uint32_t now) noexcept {
+		if ((kind == Kind::pending || kind == Kind::flush) && isBusy(lcd, now)) {
+			return false;
+		}
+		if (kind == Kind::pending) {
+			start();
+		}
+
+		if (kind == Kind::flush) {
+			LCD_flushFrame(frame(), LCD_CORO_FLUSH_CHUNK);
+			return !frame()->pending;
+		}
+
+		return kind != Kind::timed || static_cast<int32_t>(now - due) >= 0;
+	}
+
+private:
+	friend class Display;
+
+	// transfer of an operation, which is made once no other coroutine is waiting for the LCD to execute an instruction
+	using Transfer = HAL_StatusTypeDef (*)(Op &op);
+
+	enum class Kind : uint8_t {
+		pending,	// the transfer of the operation has not been made yet
+		done,		// the operation completes once its transfer is made
+		timed,		// the operation completes once the deadline passes
+		flush		// the operation completes once the frame has been flushed
+	};
+
+	/**
+	 * @brief						Creates an operation that makes its transfer right away, or once it is polled after the LCD has executed an instruction for another coroutine
+	 *
+	 * @param		lcd				Pointer to LCD structure
+	 * @param		transfer		Transfer of the operation
+	 * @param		data			Data of the transfer
+	 * @param		arg				Argument of the transfer
+	 */
+	Op(HD44780_LCD_t *lcd, Transfer transfer, const void *data, uint8_t arg) noexcept
+			: lcd(lcd), data(data), transfer(transfer), arg(arg), status(HAL_OK), kind(Kind::pending) {
+		if (!isBusy(lcd, HAL_GetTick())) {
+			start();
+		}
+	}
+
+	/**
+	 * @brief						Returns whether a coroutine is suspended on an instruction that the LCD is still executing
+	 *
+	 * @param		lcd				Pointer to LCD structure
+	 * @param		now				Current tick
+	 *
+	 * @return						true if the transfers to the LCD must wait
+	 */
+	static bool isBusy(const HD44780_LCD_t *lcd, uint32_t now) noexcept {
+		for (const detail::Waiter &waiter : detail::waiters) {
+			const Op *op = waiter.op;
+
+			if (waiter.handle && op->lcd == lcd && op->kind == Kind::timed && static_cast<int32_t>(now - op->due) < 0) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief						Returns the frame flushed by the operation
+	 *
+	 * @return						Pointer to the frame
+	 */
+	HD44780_LCD_Frame_t *frame() const noexcept {
+		return static_cast<HD44780_LCD_Frame_t *>(const_cast<void *>(data));
+	}
+
+	/**
+	 * @brief						Makes the transfer of the operation
+	 */
+	void start() noexcept {
+		kind = Kind::done;
+		status = transfer(*this);
+	}
+
+	/**
+	 * @brief						Makes the operation complete once a number of microseconds have passed from now
+	 *
+	 * @param		waitUs			Number of microseconds to wait for
+	 */
+	void wait(uint32_t waitUs) noexcept {
+		kind = (waitUs != 0) ? (Kind::timed) : (Kind::done);
+		us = waitUs;
+
+		// the tick in progress is not counted, as with LCD_sleepUs
+		due = HAL_GetTick() + (waitUs + 999U) / 1000U + 1U;
+	}
+
+	HD44780_LCD_t *lcd;				// LCD that the operation transfers to (nullptr if it only waits)
+	const void *data;				// data of the transfer, or the frame being flushed
+
+	// the transfer is only needed until it is made, and the deadline only after it, so they share storage
+	union {
+		Transfer transfer;			// transfer that has not been made yet
+		struct {
+			uint32_t due;			// tick at which a timed operation completes
+			uint32_t us;			// number of microseconds a timed operation waits for
+		};
+	};
+
+	uint8_t arg;					// argument of the transfer (a location, an instruction or a position)
+	uint8_t status;					// status of the transfers (a HAL_StatusTypeDef)
+	Kind kind;
+};
+
+/**
+ * @brief							Resumes the coroutines whose operations have completed, and must be called periodically (e.g. from the main loop)
+ *
+ * Coroutines are only ever resumed from here, so they never run in interrupt handlers
+ *
+ * @return							Number of coroutines that were resumed
+ */
+inline uint32_t poll() noexcept {
+	const uint32_t now = HAL_GetTick();
+	uint32_t resumed = 0;
+
+	for (detail::Waiter &waiter : detail::waiters) {
+		if (!waiter.handle || !waiter.op->poll(now)) {
+			continue;
+		}
+
+		// the waiter is released first, as the coroutine may wait again before resume returns
+		const std::coroutine_handle<> handle = waiter.handle;
+		waiter.handle = nullptr;
+		handle.resume();
+		++resumed;
+	}
+
+	detail::stats.resumes += resumed;
+	return resumed;
+}
+
+/**
+ * @brief							Returns the statistics of the coroutine front end
+ *
+ * @return							Reference to the statistics
+ */
+inline const Stats &stats() noexcept {
+	return detail::stats;
+}
+
+/**
+ * @brief							Waits for a duration without blocking the core (with the resolution of the HAL tick)
+ *
+ * @param		duration			Duration to wait for
+ *
+ * @return							Operation that completes once the duration has passed
+ */
+inline Op sleep(std::chrono::milliseconds duration) noexcept {
+	return Op(HAL_OK, static_cast<uint32_t>(duration.count()) * 1000U);
+}
+
+/**
+ * @brief							LCD driven by the C driver, whose operations are awaited by coroutines
+ */
+class Display {
+public:
+	/**
+	 * @brief						Creates a display for an LCD, which must be initialized before its operations are awaited
+	 *
+	 * @param		lcd				Pointer to LCD structure
+	 * @param		frame			Pointer to a frame of the LCD, which is sent by flush (nullptr if it is not used)
+	 */
+	explicit Display(HD44780_LCD_t *lcd, HD44780_LCD_Frame_t *frame = nullptr) noexcept : lcd(lcd), frame(frame) {
+	}
+
+	/**
+	 * @brief						Writes text at the position of the cursor
+	 *
+	 * @param		msg				Null-terminated text
+	 *
+	 * @return						Operation that completes once the text was sent
+	 */
+	Op write(const char *msg) noexcept {
+		return Op(lcd, [](Op &op) {
+			return writeText(op.lcd, static_cast<const char *>(op.data));
+		}, msg, 0);
+	}
+
+	/**
+	 * @brief						Writes text starting at a position
+	 *
+	 * @param		row				Row of the first character (0 or 1)
+	 * @param		col				Column of the first character
+	 * @param		msg				Null-terminated text
+	 *
+	 * @return						Operation that completes once the text was sent
+	 */
+	Op write(uint8_t row, uint8_t col, const char *msg) noexcept {
+		// the row is kept in the highest bit of the argument, as columns are below LCD_LINE_SIZE
+		return Op(lcd, [](Op &op) {
+			LCD_setCursorPos(op.lcd, op.arg >> 7, op.arg & 0x7F);
+			return writeText(op.lcd, static_cast<const char *>(op.data));
+		}, msg, static_cast<uint8_t>((row << 7) | (col & 0x7F)));
+	}
+
+	/**
+	 * @brief						Writes text encoded at compile time at the position of the cursor
+	 *
+	 * @param		codes			Codes of the characters (e.g. hd44780::romText<romA00, "25°C">)
+	 *
+	 * @return						Operation that completes once the text was sent
+	 */
+	template <std::size_t N>
+	Op write(const std::array<uint8_t, N> &codes) noexcept {
+		return Op(lcd, [](Op &op) {
+			return send(op.lcd, *static_cast<const std::array<uint8_t, N> *>(op.data));
+		}, &codes, 0);
+	}
+
+#if LCD_USE_I2C
+	/**
+	 * @brief						Writes text encoded at compile time into the frames of a PC8574 Expander at the position of the cursor
+	 *
+	 * @param		text			Codes and frames of the text (e.g. hd44780::pcf8574Text<romA00, "25°C">)
+	 *
+	 * @return						Operation that completes once the text was sent
+	 */
+	template <std::size_t N>
+	Op write(const Pcf8574Text<N> &text) noexcept {
+		return Op(lcd, [](Op &op) {
+			return send(op.lcd, *static_cast<const Pcf8574Text<N> *>(op.data));
+		}, &text, 0);
+	}
+#endif
+
+	/**
+	 * @brief						Sends the cells of the frame of the display that changed, a few at a time so other coroutines run in between
+	 *
+	 * @return						Operation that completes once every cell was sent
+	 */
+	Op flush() noexcept {
+		if (frame == nullptr) {
+			return Op(HAL_ERROR);
+		}
+
+		return Op(frame);
+	}
+
+	/**
+	 * @brief						Loads a glyph into the Character Generator RAM
+	 *
+	 * @param		loc				Location of the glyph (0 to 7)
+	 * @param		rows			Rows of the glyph
+	 *
+	 * @return						Operation that completes once the glyph was sent
+	 */
+	Op loadGlyph(uint8_t loc, const uint8_t (&rows)[8]) noexcept {
+		return Op(lcd, createGlyph, rows, loc);
+	}
+
+	/**
+	 * @brief						Loads a glyph drawn at compile time into the Character Generator RAM
+	 *
+	 * @param		loc				Location of the glyph (0 to 7)
+	 * @param		rows			Rows of the glyph (e.g. hd44780::glyph("..#..", ".###.", "#####"))
+	 *
+	 * @return						Operation that completes once the glyph was sent
+	 */
+	Op loadGlyph(uint8_t loc, const Glyph &rows) noexcept {
+		return Op(lcd, createGlyph, rows.data(), loc);
+	}
+
+	/**
+	 * @brief						Clears the display and returns the cursor home, without busy-waiting for the LCD to execute it
+	 *
+	 * @return						Operation that completes once the LCD has cleared the display
+	 */
+	Op clear() noexcept {
+		return Op(lcd, startInstruction, nullptr, LCD_CLEAR_DISPLAY);
+	}
+
+	/**
+	 * @brief						Returns the cursor home and undoes any scrolling, without busy-waiting for the LCD to execute it
+	 *
+	 * @return						Operation that completes once the LCD has returned home
+	 */
+	Op home() noexcept {
+		return Op(lcd, startInstruction, nullptr, LCD_SET_CURSOR_HOME);
+	}
+
+	/**
+	 * @brief						Returns the LCD of the display, through which the rest of the library is used
+	 *
+	 * @return						Pointer to LCD structure
+	 */
+	HD44780_LCD_t *get() const noexcept {
+		return lcd;
+	}
+
+private:
+	/**
+	 * @brief						Writes null-terminated text at the position of the cursor
+	 *
+	 * @param		lcd				Pointer to LCD structure
+	 * @param		msg				Null-terminated text
+	 *
+	 * @return						Status of the transfer to the LCD
+	 */
+	static HAL_StatusTypeDef writeText(HD44780_LCD_t *lcd, const char *msg) noexcept {
+		uint32_t len = 0;
+
+		while (msg[len] != '\0') {
+			++len;
+		}
+
+		return LCD_sendBuffer(lcd, reinterpret_cast<const uint8_t *>(msg), len);
+	}
+
+	/**
+	 * @brief						Loads the glyph of an operation into the Character Generator RAM
+	 *
+	 * @param		op				Operation holding the location and the rows of the glyph
+	 *
+	 * @return						Status of the transfers to the LCD
+	 */
+	static HAL_StatusTypeDef createGlyph(Op &op) noexcept {
+		return LCD_createCustomChar(op.lcd, op.arg, static_cast<const uint8_t *>(op.data));
+	}
+
+	/**
+	 * @brief						Sends the instruction of an operation without busy-waiting for the LCD to execute it, after which the operation waits for it
+	 *
+	 * @param		op				Operation holding the instruction
+	 *
+	 * @return						Status of the transfer to the LCD
+	 */
+	static HAL_StatusTypeDef startInstruction(Op &op) noexcept {
+		uint32_t execUs;
+		const HAL_StatusTypeDef status = LCD_startInstruction(op.lcd, op.arg, &execUs);
+
+		op.wait(execUs);
+		return status;
+	}
+
+	HD44780_LCD_t *lcd;
+	HD44780_LCD_Frame_t *frame;
+};
+
+} // namespace hd44780
+
+#endif /* HD44780_LCD_HPP_ */
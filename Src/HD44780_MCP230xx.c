@@ -0,0 +1,307 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_MCP230xx.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains definitions of the MCP23008 and MCP23017 I2C Expanders used to drive 16x2 Character Liquid Crystal Displays along with the HD44780 Controller
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if LCD_USE_I2C
+// address of the I/O Direction register of the MCP23008
+#define   MCP23008_IODIR		0x00
+// address of the I/O Configuration register of the MCP23008
+#define   MCP23008_IOCON		0x05
+// address of the Output Latch register of the MCP23008
+#define   MCP23008_OLAT			0x0A
+
+// address of the I/O Direction register of port A of the MCP23017 (IOCON.BANK = 0, port B follows it)
+#define   MCP23017_IODIRA		0x00
+// address of the I/O Configuration register of the MCP23017 (IOCON.BANK = 0)
+#define   MCP23017_IOCON		0x0A
+// address of the Output Latch register of port A of the MCP23017 (IOCON.BANK = 0, port B follows it)
+#define   MCP23017_OLATA		0x14
+
+// mask of the Sequential Operation bit of the IOCON register, which when set keeps the register pointer on the same register (MCP23008) or register pair (MCP23017)
+#define   MCP230XX_IOCON_SEQOP	0x20
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Configures an MCP23008 to drive the LCD (sequential operation disabled, all pins as outputs, backlight restored)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfers to the Expander
+ */
+static HAL_StatusTypeDef LCD_configureMCP23008(HD44780_LCD_t *lcd) {
+	uint8_t iocon[] = {MCP23008_IOCON, MCP230XX_IOCON_SEQOP};
+	uint8_t iodir[] = {MCP23008_IODIR, 0x00};
+	uint8_t olat[] = {MCP23008_OLAT, lcd->backlightMask};
+
+	HAL_StatusTypeDef status = LCD_transmitI2C(lcd, iocon, sizeof(iocon));
+	if (status == HAL_OK) {
+		status = LCD_transmitI2C(lcd, iodir, sizeof(iodir));
+	}
+	if (status == HAL_OK) {
+		status = LCD_transmitI2C(lcd, olat, sizeof(olat));
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends the higher nibble of an instruction to the LCD via an MCP23008
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction whose higher nibble is sent
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitMCP23008(HD44780_LCD_t *lcd, uint8_t instruction) {
+	const uint8_t enMask = 1 << lcd->expanderPins.en;
+	const uint8_t value = LCD_I2C_NIBBLE(lcd, 0, HI_NIBBLE(instruction));
+
+	uint8_t buf[] = {MCP23008_OLAT, value, value | enMask, value};
+	return LCD_transmitI2C(lcd, buf, sizeof(buf));
+}
+
+/**
+ * @brief							Streams a sequence of bytes to the LCD via an MCP23008 as nibbles, LCD_I2C_STREAM_CHUNK bytes per transfer
+ *
+ * Since sequential operation is disabled, every byte after the register address is written to the output latch. RS is set once at the start of each transfer,
+ * after which each nibble takes two bytes (presented along with the rising edge of EN, held through its falling edge)
+ *
+ * The two bytes between the end of one byte and the end of the next must cover the execution time of the variant. If the bus is too fast for that,
+ * one byte is sent per transfer, and the execution time is waited for after each transfer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first chunk that fails)
+ */
+static HAL_StatusTypeDef LCD_writeMCP23008(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	const uint8_t enMask = 1 << lcd->expanderPins.en;
+	const uint32_t chunk = (LCD_I2C_COVERS_US(2, lcd->variant->execUs)) ? (LCD_I2C_STREAM_CHUNK) : (1);
+	HAL_StatusTypeDef status = HAL_OK;
+
+	uint8_t frame[2 + 4 * LCD_I2C_STREAM_CHUNK];
+
+	while (len > 0 && status == HAL_OK) {
+		const uint32_t count = (len < chunk) ? (len) : (chunk);
+		uint32_t pos = 0;
+
+		frame[pos++] = MCP23008_OLAT;
+		frame[pos++] = LCD_I2C_NIBBLE(lcd, isData, 0);
+
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint8_t hi = LCD_I2C_NIBBLE(lcd, isData, HI_NIBBLE(buf[i]));
+			const uint8_t lo = LCD_I2C_NIBBLE(lcd, isData, LO_NIBBLE(buf[i]));
+
+			frame[pos++] = hi | enMask;
+			frame[pos++] = hi;
+			frame[pos++] = lo | enMask;
+			frame[pos++] = lo;
+		}
+
+		status = LCD_transmitI2C(lcd, frame, pos);
+		if (chunk == 1) {
+			LCD_delayUs(lcd->variant->execUs);
+		}
+		buf += count;
+		len -= count;
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Updates the state of the backlight driven by an MCP23008
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeBacklightMCP23008(HD44780_LCD_t *lcd) {
+	uint8_t buf[2];
+
+	LCD_encodeI2CNibbles(lcd);
+	buf[0] = MCP23008_OLAT;
+	buf[1] = lcd->backlightMask;
+	return LCD_transmitI2C(lcd, buf, sizeof(buf));
+}
+
+/**
+ * @brief							Configures an MCP23017 to drive the LCD (sequential operation disabled, all pins of both ports as outputs, backlight restored)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfers to the Expander
+ */
+static HAL_StatusTypeDef LCD_configureMCP23017(HD44780_LCD_t *lcd) {
+	uint8_t iocon[] = {MCP23017_IOCON, MCP230XX_IOCON_SEQOP};
+	uint8_t iodir[] = {MCP23017_IODIRA, 0x00, 0x00};
+	uint8_t olat[] = {MCP23017_OLATA, 0x00, lcd->backlightMask};
+
+	HAL_StatusTypeDef status = LCD_transmitI2C(lcd, iocon, sizeof(iocon));
+	if (status == HAL_OK) {
+		status = LCD_transmitI2C(lcd, iodir, sizeof(iodir));
+	}
+	if (status == HAL_OK) {
+		status = LCD_transmitI2C(lcd, olat, sizeof(olat));
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Streams a sequence of bytes to the LCD via an MCP23017 in 8-bit mode, LCD_I2C_STREAM_CHUNK bytes per transfer
+ *
+ * Since sequential operation is disabled, the register pointer toggles between the output latches of port A (D0-D7) and port B (RS, EN, backlight).
+ * RS is set once at the start of each transfer, after which each byte takes one register pair with EN high and one with EN low
+ *
+ * The four bytes between the end of one byte and the end of the next must cover the execution time of the variant. If the bus is too fast for that,
+ * one byte is sent per transfer, and the execution time is waited for after each transfer
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first chunk that fails)
+ */
+static HAL_StatusTypeDef LCD_writeMCP23017(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	// the data pins of the pin map are unused, so the pre-encoded value of the zero nibble holds only RS and the backlight
+	const uint8_t control = LCD_I2C_NIBBLE(lcd, isData, 0);
+	const uint8_t enMask = 1 << lcd->expanderPins.en;
+	const uint32_t chunk = (LCD_I2C_COVERS_US(4, lcd->variant->execUs)) ? (LCD_I2C_STREAM_CHUNK) : (1);
+	HAL_StatusTypeDef status = HAL_OK;
+
+	uint8_t frame[3 + 4 * LCD_I2C_STREAM_CHUNK];
+
+	while (len > 0 && status == HAL_OK) {
+		const uint32_t count = (len < chunk) ? (len) : (chunk);
+		uint32_t pos = 0;
+
+		frame[pos++] = MCP23017_OLATA;
+		frame[pos++] = buf[0];
+		frame[pos++] = control;
+
+		for (uint32_t i = 0; i < count; ++i) {
+			frame[pos++] = buf[i];
+			frame[pos++] = control | enMask;
+			frame[pos++] = buf[i];
+			frame[pos++] = control;
+		}
+
+		status = LCD_transmitI2C(lcd, frame, pos);
+		if (chunk == 1) {
+			LCD_delayUs(lcd->variant->execUs);
+		}
+		buf += count;
+		len -= count;
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends an instruction to the LCD via an MCP23017 (the whole instruction is sent, as the data bus is 8 bits wide)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitMCP23017(HD44780_LCD_t *lcd, uint8_t instruction) {
+	return LCD_writeMCP23017(lcd, &instruction, 1, 0);
+}
+
+/**
+ * @brief							Updates the state of the backlight driven by an MCP23017
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeBacklightMCP23017(HD44780_LCD_t *lcd) {
+	uint8_t buf[2];
+
+	LCD_encodeI2CNibbles(lcd);
+	buf[0] = MCP23017_OLATA + 1;
+	buf[1] = lcd->backlightMask;
+	return LCD_transmitI2C(lcd, buf, sizeof(buf));
+}
+
+/** Expanders ----------------------------------------------------------------*/
+
+// MCP23008 Expander, which drives the LCD in 4-bit mode
+const HD44780_LCD_Transport_t LCD_MCP23008 = {
+	.busSize = LCD_BUS_SIZE_4,
+	.configure = LCD_configureMCP23008,
+	.writeInit = LCD_writeInitMCP23008,
+	.write = LCD_writeMCP23008,
+	.writeBacklight = LCD_writeBacklightMCP23008
+};
+
+// MCP23017 Expander, which drives the LCD in 8-bit mode with D0-D7 on port A and the control lines on port B
+const HD44780_LCD_Transport_t LCD_MCP23017 = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureMCP23017,
+	.writeInit = LCD_writeInitMCP23017,
+	.write = LCD_writeMCP23017,
+	.writeBacklight = LCD_writeBacklightMCP23017
+};
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes the LCD to be used along with an MCP23008 Expander controlled via I2C
+ *
+ * If no pin map is given, the wiring of the Adafruit I2C/SPI backpack is used (RS on GP1, EN on GP2, D4-D7 on GP3-GP6 and the backlight on GP7)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the Expander on the I2C bus
+ * @param		pins				Pointer to the pin map of the Expander (indices of the bits of GP0-GP7), or NULL for the default
+ */
+void LCD_createMCP23008(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins) {
+	static const HD44780_LCD_ExpanderPins_t defaultPins = {
+		.rs = 1, .en = 2, .backlight = 7, .data = {3, 4, 5, 6}
+	};
+
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+
+	lcd->transport = &LCD_MCP23008;
+	LCD_setI2CPins(lcd, (pins != NULL) ? (pins) : (&defaultPins));
+}
+
+/**
+ * @brief							Initializes the LCD to be used along with an MCP23017 Expander controlled via I2C, which drives the LCD in 8-bit mode
+ *
+ * D0-D7 of the LCD must be wired to GPA0-GPA7. If no pin map is given, RS is on GPB0, EN on GPB2 and the backlight on GPB3 (RW, if wired, must be on GPB1 or tied low)
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the Expander on the I2C bus
+ * @param		pins				Pointer to the pin map of the Expander (indices of the bits of GPB0-GPB7, the data pins are unused), or NULL for the default
+ */
+void LCD_createMCP23017(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr,
+		const HD44780_LCD_ExpanderPins_t *pins) {
+	static const HD44780_LCD_ExpanderPins_t defaultPins = {
+		.rs = 0, .en = 2, .backlight = 3, .data = {0, 0, 0, 0}
+	};
+
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+
+	lcd->transport = &LCD_MCP23017;
+	LCD_setI2CPins(lcd, (pins != NULL) ? (pins) : (&defaultPins));
+}
+#endif
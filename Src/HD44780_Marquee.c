@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Marquee.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the marquees, which scroll text longer than the visible part of a line by shifting the display, or a pixel at a time through the CGRAM
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if LCD_VISIBLE_COLS >= LCD_LINE_SIZE
+#error "LCD_VISIBLE_COLS must be less than LCD_LINE_SIZE"
+#endif
+
+// the number of pixel columns of a cell (and of a character of the built-in font)
+#define   CELL_WIDTH			5
+// the number of pixel columns each character of a smooth marquee takes (the columns of the font followed by a blank column)
+#define   CHAR_ADVANCE			(CELL_WIDTH + 1)
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Returns a character of the looped text of a marquee
+ *
+ * @param		marquee				Pointer to the marquee
+ * @param		index				Index of the character (any value, the text is looped)
+ *
+ * @return							Character of the text, or a space if the index falls on the padding of a short text
+ */
+static uint8_t LCD_marqueeChar(const HD44780_LCD_Marquee_t *marquee, uint32_t index) {
+	index %= marquee->period;
+
+	return (index < marquee->len) ? (marquee->text[index]) : (' ');
+}
+
+/**
+ * @brief							Draws the pixels a cell of a smooth marquee shows at its current position, using the built-in font
+ *
+ * @param		marquee				Pointer to the smooth marquee
+ * @param		cell				Index of the cell within the segment
+ * @param		glyph				Rows of the glyph of the cell
+ */
+static void LCD_drawSmoothCell(const HD44780_LCD_SmoothMarquee_t *marquee, uint32_t cell, uint8_t glyph[8]) {
+	const uint32_t period = marquee->len * CHAR_ADVANCE;
+	uint32_t x = (marquee->pos + cell * CELL_WIDTH) % period;
+
+	for (uint32_t row = 0; row < 8; ++row) {
+		glyph[row] = 0;
+	}
+
+	for (uint32_t k = 0; k < CELL_WIDTH; ++k) {
+		// the last column of each character is blank, so neighbouring characters do not touch
+		const uint8_t column = (x % CHAR_ADVANCE == CELL_WIDTH) ? (0) : (LCD_fontColumns(marquee->text[x / CHAR_ADVANCE])[x % CHAR_ADVANCE]);
+
+		for (uint32_t row = 0; row < 8; ++row) {
+			glyph[row] |= ((column >> row) & 1) << (CELL_WIDTH - 1 - k);
+		}
+		if (++x == period) {
+			x = 0;
+		}
+	}
+}
+
+/**
+ * @brief							Shows a smooth marquee at its current position, sending only the rows of glyphs and the cells that changed
+ *
+ * @param		marquee				Pointer to the smooth marquee
+ *
+ * @return							Status of the transfers to the LCD (the update stops at the first transfer that fails)
+ */
+static HAL_StatusTypeDef LCD_renderSmoothMarquee(HD44780_LCD_SmoothMarquee_t *marquee) {
+	HD44780_LCD_t *lcd = marquee->lcd;
+	uint8_t codes[LCD_CGRAM_GLYPHS];
+	HAL_StatusTypeDef status = HAL_OK;
+
+	// glyphs are loaded before the cells, so a cell that stops showing a space shows the new rows of its glyph at once
+	for (uint32_t cell = 0; cell < marquee->width && status == HAL_OK; ++cell) {
+		const uint8_t loc = marquee->firstLoc + cell;
+		uint8_t glyph[8];
+		uint8_t pixels = 0;
+
+		LCD_drawSmoothCell(marquee, cell, glyph);
+
+		for (uint32_t row = 0; row < 8; ++row) {
+			pixels |= glyph[row];
+		}
+
+		// a blank cell shows a space from the ROM, and its glyph is left as it was
+		if (pixels == 0) {
+			codes[cell] = ' ';
+			continue;
+		}
+
+		// glyphs of consecutive cells are consecutive in the CGRAM, so the address counter often already points at the first changed row
+		codes[cell] = loc;
+		status = LCD_updateCustomChar(lcd, loc, glyph);
+	}
+
+	for (uint32_t cell = 0; cell < marquee->width && status == HAL_OK; ++cell) {
+		const uint32_t col = marquee->col + cell;
+		const uint8_t addr = ((marquee->row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+
+		if (LCD_SHADOW_DDRAM_IS(lcd, marquee->row, col, codes[cell])) {
+			continue;
+		}
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, marquee->row, col);
+		}
+		status = LCD_sendData(lcd, codes[cell]);
+	}
+
+	return status;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a marquee on a row, and fills the whole DDRAM line with its text starting at the left-most visible column
+ *
+ * The display shift moves both lines, so the other row scrolls along with the marquee. Text of up to LCD_LINE_SIZE characters is padded with spaces
+ * and held entirely in the DDRAM, so each step is a single shift instruction. Longer text is looped, and each step also rewrites the off-screen column
+ * that comes into view with the next one
+ *
+ * @param		marquee				Pointer to the marquee
+ * @param		lcd					Pointer to LCD structure
+ * @param		row					Row of the marquee (0 or 1)
+ * @param		text				Pointer to the text (must remain valid while the marquee is stepped)
+ * @param		len					Number of characters of the text (at least 1)
+ *
+ * @return							Status of the transfers to the LCD
+ */
+HAL_StatusTypeDef LCD_initMarquee(HD44780_LCD_Marquee_t *marquee, HD44780_LCD_t *lcd, uint8_t row, const uint8_t *text, uint16_t len) {
+	const uint32_t first = lcd->shadow.shift;
+	uint8_t line[LCD_LINE_SIZE];
+
+	marquee->lcd = lcd;
+	marquee->text = text;
+	marquee->len = len;
+	marquee->period = (len > LCD_LINE_SIZE) ? (len) : (LCD_LINE_SIZE);
+	marquee->pos = 0;
+	marquee->row = row;
+
+	// the line is written with the cursor moving right, which the DDRAM wraps from the last column to the next line
+	if (lcd->cursorMovement != (LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC)) {
+		LCD_setCursorAutoInc(lcd);
+	}
+
+	// column c of the line shows the character (c - first) of the text, so the text starts at the left-most visible column
+	for (uint32_t col = 0; col < LCD_LINE_SIZE; ++col) {
+		line[col] = LCD_marqueeChar(marquee, (col + LCD_LINE_SIZE - first) % LCD_LINE_SIZE);
+	}
+
+	LCD_setCursorPos(lcd, row, 0);
+	return LCD_sendBuffer(lcd, line, LCD_LINE_SIZE);
+}
+
+/**
+ * @brief							Scrolls a marquee left by one character
+ *
+ * @param		marquee				Pointer to the marquee
+ *
+ * @return							Status of the transfers to the LCD
+ */
+HAL_StatusTypeDef LCD_stepMarquee(HD44780_LCD_Marquee_t *marquee) {
+	HD44780_LCD_t *lcd = marquee->lcd;
+	HAL_StatusTypeDef status;
+	uint32_t col;
+	uint8_t data;
+
+	status = LCD_sendInstruction(lcd, LCD_SHIFT_CURSOR | LCD_DISPLAY_MOVE_LT);
+	marquee->pos = (marquee->pos + 1) % marquee->period;
+
+	// the DDRAM holds the whole text, which the shift wraps around by itself
+	if (marquee->period == LCD_LINE_SIZE) {
+		return status;
+	}
+
+	// the column that comes into view with the next step is rewritten while it is still off-screen
+	col = (lcd->shadow.shift + LCD_VISIBLE_COLS) % LCD_LINE_SIZE;
+	data = LCD_marqueeChar(marquee, marquee->pos + LCD_VISIBLE_COLS);
+
+	if (status == HAL_OK && !LCD_SHADOW_DDRAM_IS(lcd, marquee->row, col, data)) {
+		const uint8_t addr = ((marquee->row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + col;
+
+		// the previous step left the address counter on this column, unless it skipped its write
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, marquee->row, col);
+		}
+		status = LCD_sendData(lcd, data);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Initializes a smooth marquee, which scrolls text through a segment of a row one pixel column at a time, and shows its first position
+ *
+ * Each cell of the segment shows its own glyph, drawn from the built-in font, so the segment takes one location of the CGRAM per cell. Each step
+ * reloads only the rows of the glyphs that changed, and a cell whose pixels are all blank shows a space from the ROM instead of its glyph
+ *
+ * @param		marquee				Pointer to the smooth marquee
+ * @param		lcd					Pointer to LCD structure
+ * @param		row					Row of the segment (0 or 1)
+ * @param		col					Column of the first cell of the segment
+ * @param		width				Number of cells of the segment (1 to LCD_CGRAM_GLYPHS - firstLoc)
+ * @param		firstLoc			Location of the glyph of the first cell of the segment
+ * @param		text				Pointer to the text, which is looped (must remain valid while the marquee is stepped)
+ * @param		len					Number of characters of the text (1 to 10922, as each takes 6 pixel columns)
+ *
+ * @return							Status of the transfers to the LCD, HAL_ERROR if the segment does not fit in the CGRAM
+ */
+HAL_StatusTypeDef LCD_initSmoothMarquee(HD44780_LCD_SmoothMarquee_t *marquee, HD44780_LCD_t *lcd, uint8_t row, uint8_t col, uint8_t width,
+		uint8_t firstLoc, const uint8_t *text, uint16_t len) {
+	if (width == 0 || firstLoc + width > LCD_CGRAM_GLYPHS || len == 0 || len > 0xFFFF / CHAR_ADVANCE) {
+		return HAL_ERROR;
+	}
+
+	marquee->lcd = lcd;
+	marquee->text = text;
+	marquee->len = len;
+	marquee->pos = 0;
+	marquee->row = row;
+	marquee->col = col;
+	marquee->width = width;
+	marquee->firstLoc = firstLoc;
+
+	return LCD_renderSmoothMarquee(marquee);
+}
+
+/**
+ * @brief							Scrolls a smooth marquee left by one pixel column
+ *
+ * @param		marquee				Pointer to the smooth marquee
+ *
+ * @return							Status of the transfers to the LCD
+ */
+HAL_StatusTypeDef LCD_stepSmoothMarquee(HD44780_LCD_SmoothMarquee_t *marquee) {
+	marquee->pos = (marquee->pos + 1) % (marquee->len * CHAR_ADVANCE);
+
+	return LCD_renderSmoothMarquee(marquee);
+}
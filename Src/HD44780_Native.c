@@ -0,0 +1,461 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Native.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains definitions of the HD44780-compatible controllers with a native I2C or SPI interface (ST7032, ST7036, AiP31068, US2066 and WS0010) and of their extended instructions
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if LCD_USE_I2C || LCD_USE_SPI
+// control byte that precedes a stream of instructions sent via I2C (Co = 0, RS = 0)
+#define   NATIVE_CONTROL_INSTR	0x00
+// control byte that precedes a stream of data sent via I2C (Co = 0, RS = 1)
+#define   NATIVE_CONTROL_DATA	0x40
+
+// bit of a 10-bit SPI frame of the WS0010 that selects the Data Register
+#define   WS0010_FRAME_RS		0x200
+
+// the function set used while the extended instructions are sent (8-bit bus and 2 lines, as set by LCD_init)
+#define   EXT_FUNCTION			(LCD_SET_FUNCTION | LCD_BUS_SIZE_8 | LCD_DOT_COUNT_8 | LCD_LINE_COUNT_2)
+
+/** Private Functions --------------------------------------------------------*/
+
+#if LCD_USE_I2C
+/**
+ * @brief							Streams a sequence of bytes to a controller with a native I2C interface, LCD_I2C_STREAM_CHUNK bytes per transfer
+ *
+ * Each transfer is a single control byte (which selects instructions or data) followed by the bytes themselves. The controller executes each byte
+ * as it is received, so if a byte clocks out faster than the execution time of the variant, one byte is sent per transfer followed by that wait
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first chunk that fails)
+ */
+static HAL_StatusTypeDef LCD_writeNativeI2C(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	const uint32_t chunk = (LCD_I2C_COVERS_US(1, lcd->variant->execUs)) ? (LCD_I2C_STREAM_CHUNK) : (1);
+	HAL_StatusTypeDef status = HAL_OK;
+
+	uint8_t frame[1 + LCD_I2C_STREAM_CHUNK];
+
+	while (len > 0 && status == HAL_OK) {
+		const uint32_t count = (len < chunk) ? (len) : (chunk);
+
+		frame[0] = (isData) ? (NATIVE_CONTROL_DATA) : (NATIVE_CONTROL_INSTR);
+		for (uint32_t i = 0; i < count; ++i) {
+			frame[1 + i] = buf[i];
+		}
+
+		status = LCD_transmitI2C(lcd, frame, 1 + count);
+		if (chunk == 1) {
+			LCD_delayUs(lcd->variant->execUs);
+		}
+		buf += count;
+		len -= count;
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends an instruction to a controller with a native I2C interface
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitNativeI2C(HD44780_LCD_t *lcd, uint8_t instruction) {
+	return LCD_writeNativeI2C(lcd, &instruction, 1, 0);
+}
+
+#endif
+
+#if LCD_USE_SPI
+/**
+ * @brief							Sends a sequence of bytes to a controller with a native SPI interface, waiting for each byte to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first byte that fails)
+ */
+static HAL_StatusTypeDef LCD_writeNativeSPI(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	LCD_WRITE_PIN(lcd->rsPin, (isData) ? (GPIO_PIN_SET) : (GPIO_PIN_RESET));
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_RESET);
+
+	// the controller has no busy flag over SPI, so each byte is given its execution time before the next is sent
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		status = HAL_SPI_Transmit(lcd->SPIHandle, (uint8_t *) &(buf[i]), 1, LCD_SPI_TIMEOUT);
+		LCD_delayUs(lcd->variant->execUs);
+	}
+
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_SET);
+
+	return status;
+}
+
+/**
+ * @brief							Sends an instruction to a controller with a native SPI interface
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitNativeSPI(HD44780_LCD_t *lcd, uint8_t instruction) {
+	return LCD_writeNativeSPI(lcd, &instruction, 1, 0);
+}
+
+/**
+ * @brief							Sends a sequence of bytes to a WS0010 controller via 3-wire SPI, as 10-bit frames (RS, R/W, D7-D0), waiting for each byte to be executed
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		buf					Pointer to the bytes
+ * @param		len					Number of bytes
+ * @param		isData				Whether the bytes are instructions (0) or Data (1)
+ *
+ * @return							Status of the transfer to the LCD (the transfer stops at the first byte that fails)
+ */
+static HAL_StatusTypeDef LCD_writeWS0010SPI(HD44780_LCD_t *lcd, const uint8_t *buf, uint32_t len, uint8_t isData) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_RESET);
+
+	for (uint32_t i = 0; i < len && status == HAL_OK; ++i) {
+		uint16_t frame = ((isData) ? (WS0010_FRAME_RS) : (0)) | buf[i];
+
+		status = HAL_SPI_Transmit(lcd->SPIHandle, (uint8_t *) &frame, 1, LCD_SPI_TIMEOUT);
+		LCD_delayUs(lcd->variant->execUs);
+	}
+
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_SET);
+
+	return status;
+}
+
+/**
+ * @brief							Sends an instruction to a WS0010 controller via 3-wire SPI
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		instruction			Instruction to send
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeInitWS0010SPI(HD44780_LCD_t *lcd, uint8_t instruction) {
+	return LCD_writeWS0010SPI(lcd, &instruction, 1, 0);
+}
+#endif
+
+/**
+ * @brief							Sends a sequence of instructions from the extended instruction table of an ST7032/ST7036 controller, after which the normal table is selected again
+ *
+ * The instructions bypass LCD_sendInstruction, so they do not affect the shadow buffer of the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		ext					Pointer to the extended instructions
+ * @param		len					Number of extended instructions (at most 4)
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_sendExtended(HD44780_LCD_t *lcd, const uint8_t *ext, uint32_t len) {
+	uint8_t buf[6];
+	uint32_t pos = 0;
+
+	buf[pos++] = EXT_FUNCTION | LCD_EXT_TABLE;
+	for (uint32_t i = 0; i < len; ++i) {
+		buf[pos++] = ext[i];
+	}
+	buf[pos++] = EXT_FUNCTION;
+
+	return lcd->transport->write(lcd, buf, pos, 0);
+}
+
+/**
+ * @brief							Configures an ST7032/ST7036 controller (bias, oscillator, contrast and the voltage follower), which must be done before the display is turned on
+ *
+ * The datasheets ask for 200ms for the voltage follower to stabilize, which only delays the contrast reaching its final level, so it is not waited for
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_configureST7032(HD44780_LCD_t *lcd) {
+	const uint8_t ext[] = {
+		LCD_EXT_SET_BIAS_OSC | LCD_EXT_OSC_DEFAULT,
+		LCD_EXT_SET_CONTRAST | LO_NIBBLE(lcd->contrast),
+		LCD_EXT_POWER_ICON | lcd->extState | ((lcd->contrast >> 4) & 0x03),
+		LCD_EXT_FOLLOWER | LCD_EXT_FOLLOWER_ON
+	};
+
+	return LCD_sendExtended(lcd, ext, sizeof(ext));
+}
+
+/**
+ * @brief							Sends the contrast of the LCD to an ST7032/ST7036 controller
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+static HAL_StatusTypeDef LCD_writeContrastST7032(HD44780_LCD_t *lcd) {
+	const uint8_t ext[] = {
+		LCD_EXT_SET_CONTRAST | LO_NIBBLE(lcd->contrast),
+		LCD_EXT_POWER_ICON | lcd->extState | ((lcd->contrast >> 4) & 0x03)
+	};
+
+	return LCD_sendExtended(lcd, ext, sizeof(ext));
+}
+
+/**
+ * @brief							Checks whether the controller of the LCD has the extended instruction table of the ST7032/ST7036
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							1 if the controller has the extended instruction table, 0 otherwise
+ */
+static uint8_t LCD_hasExtended(const HD44780_LCD_t *lcd) {
+	// comparing the operation instead of the transports keeps the linker from pulling in the transport that is not used
+	return lcd->transport->writeContrast == LCD_writeContrastST7032;
+}
+
+/** Expanders ----------------------------------------------------------------*/
+
+#if LCD_USE_I2C
+// ST7032i/ST7036i controller with a native I2C interface, which has an extended instruction table for the contrast and icons
+const HD44780_LCD_Transport_t LCD_ST7032 = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureST7032,
+	.writeInit = LCD_writeInitNativeI2C,
+	.write = LCD_writeNativeI2C,
+	.writeBacklight = LCD_writeBacklightNone,
+	.writeContrast = LCD_writeContrastST7032
+};
+
+// AiP31068L controller with a native I2C interface
+const HD44780_LCD_Transport_t LCD_AIP31068 = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitNativeI2C,
+	.write = LCD_writeNativeI2C,
+	.writeBacklight = LCD_writeBacklightNone
+};
+
+// US2066 character OLED controller with a native I2C interface (its OLED setup and brightness are sent by LCD_VARIANT_US2066)
+const HD44780_LCD_Transport_t LCD_US2066 = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitNativeI2C,
+	.write = LCD_writeNativeI2C,
+	.writeBacklight = LCD_writeBacklightNone
+};
+#endif
+
+#if LCD_USE_SPI
+// ST7032/ST7036 controller with a native (4-wire) SPI interface, which has an extended instruction table for the contrast and icons
+const HD44780_LCD_Transport_t LCD_ST7032_SPI = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureST7032,
+	.writeInit = LCD_writeInitNativeSPI,
+	.write = LCD_writeNativeSPI,
+	.writeBacklight = LCD_writeBacklightNone,
+	.writeContrast = LCD_writeContrastST7032
+};
+
+// WS0010 character OLED controller with a 3-wire SPI interface
+const HD44780_LCD_Transport_t LCD_WS0010_SPI = {
+	.busSize = LCD_BUS_SIZE_8,
+	.configure = LCD_configureNone,
+	.writeInit = LCD_writeInitWS0010SPI,
+	.write = LCD_writeWS0010SPI,
+	.writeBacklight = LCD_writeBacklightNone
+};
+#endif
+
+/** Functions ----------------------------------------------------------------*/
+
+#if LCD_USE_I2C
+/**
+ * @brief							Initializes the LCD to be used with an ST7032i or ST7036i controller, which is controlled directly via I2C
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the controller on the I2C bus (ST7032_I2C_ADDR or ST7036_I2C_ADDR)
+ */
+void LCD_createST7032(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr) {
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+
+	lcd->transport = &LCD_ST7032;
+	lcd->contrast = LCD_EXT_DEFAULT_CONTRAST;
+	lcd->extState = LCD_EXT_DEFAULT_BOOST;
+
+	LCD_setVariant(lcd, &LCD_VARIANT_ST7032);
+}
+
+/**
+ * @brief							Initializes the LCD to be used with an AiP31068L controller, which is controlled directly via I2C
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the controller on the I2C bus (AIP31068_I2C_ADDR)
+ */
+void LCD_createAiP31068(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr) {
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+
+	lcd->transport = &LCD_AIP31068;
+}
+
+/**
+ * @brief							Initializes the LCD to be used with a US2066 character OLED controller, which is controlled directly via I2C
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		I2CHandle			Pointer to structure to the I2C interface that the LCD module is connected to
+ * @param		lcdAddr				Address of the controller on the I2C bus (US2066_I2C_ADDR)
+ */
+void LCD_createUS2066(HD44780_LCD_t *lcd, I2C_HandleTypeDef *I2CHandle, uint8_t lcdAddr) {
+	LCD_createI2C_addr(lcd, I2CHandle, lcdAddr);
+
+	lcd->transport = &LCD_US2066;
+	LCD_setVariant(lcd, &LCD_VARIANT_US2066);
+}
+
+#endif
+
+#if LCD_USE_SPI
+/**
+ * @brief							Initializes the LCD to be used with an ST7032 or ST7036 controller, which is controlled directly via 4-wire SPI
+ *
+ * The SPI interface must be configured as a master with 8-bit frames, MSB first and data captured on the rising edge of SCK, at most 1MHz
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		SPIHandle			Pointer to structure to the SPI interface that the LCD module is connected to
+ * @param		csPort				GPIO Port on which the Chip Select (CSB) pin of the controller is connected
+ * @param		csPin				GPIO Pin number within the port to which the Chip Select (CSB) pin of the controller is connected
+ * @param		rsPort				GPIO Port on which the Register Select (RS) pin of the controller is connected
+ * @param		rsPin				GPIO Pin number within the port to which the Register Select (RS) pin of the controller is connected
+ */
+void LCD_createST7032_SPI(HD44780_LCD_t *lcd, SPI_HandleTypeDef *SPIHandle,
+		GPIO_TypeDef *csPort, uint16_t csPin, GPIO_TypeDef *rsPort, uint16_t rsPin) {
+	LCD_createTransport(lcd, &LCD_ST7032_SPI, NULL);
+	lcd->busMode = SPI;
+	lcd->SPIHandle = SPIHandle;
+
+	lcd->csPin = LCD_encodePin(csPort, csPin);
+	lcd->rsPin = LCD_encodePin(rsPort, rsPin);
+
+	lcd->contrast = LCD_EXT_DEFAULT_CONTRAST;
+	lcd->extState = LCD_EXT_DEFAULT_BOOST;
+
+	LCD_setVariant(lcd, &LCD_VARIANT_ST7032);
+
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_SET);
+}
+
+/**
+ * @brief							Initializes the LCD to be used with a WS0010 character OLED controller, which is controlled directly via 3-wire SPI
+ *
+ * The SPI interface must be configured as a master with 10-bit frames, MSB first, CPOL = 1 and CPHA = 1, at most 1MHz
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		SPIHandle			Pointer to structure to the SPI interface that the LCD module is connected to
+ * @param		csPort				GPIO Port on which the Chip Select (CS) pin of the controller is connected
+ * @param		csPin				GPIO Pin number within the port to which the Chip Select (CS) pin of the controller is connected
+ */
+void LCD_createWS0010_SPI(HD44780_LCD_t *lcd, SPI_HandleTypeDef *SPIHandle, GPIO_TypeDef *csPort, uint16_t csPin) {
+	LCD_createTransport(lcd, &LCD_WS0010_SPI, NULL);
+	lcd->busMode = SPI;
+	lcd->SPIHandle = SPIHandle;
+
+	lcd->csPin = LCD_encodePin(csPort, csPin);
+
+	LCD_setVariant(lcd, &LCD_VARIANT_WS0010);
+
+	LCD_WRITE_PIN(lcd->csPin, GPIO_PIN_SET);
+}
+#endif
+
+/**
+ * @brief							Enables displaying the icons stored in the ICON RAM (only applicable to ST7032/ST7036 controllers)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD (HAL_ERROR if the controller does not support it)
+ */
+HAL_StatusTypeDef LCD_enableIcons(HD44780_LCD_t *lcd) {
+	if (!LCD_hasExtended(lcd)) {
+		return HAL_ERROR;
+	}
+
+	lcd->extState |= LCD_EXT_ICON_ENABLE;
+	if (!LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+
+	const uint8_t ext = LCD_EXT_POWER_ICON | lcd->extState | ((lcd->contrast >> 4) & 0x03);
+	return LCD_sendExtended(lcd, &ext, 1);
+}
+
+/**
+ * @brief							Disables displaying the icons stored in the ICON RAM (only applicable to ST7032/ST7036 controllers)
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD (HAL_ERROR if the controller does not support it)
+ */
+HAL_StatusTypeDef LCD_disableIcons(HD44780_LCD_t *lcd) {
+	if (!LCD_hasExtended(lcd)) {
+		return HAL_ERROR;
+	}
+
+	lcd->extState &= ~LCD_EXT_ICON_ENABLE;
+	if (!LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+
+	const uint8_t ext = LCD_EXT_POWER_ICON | lcd->extState | ((lcd->contrast >> 4) & 0x03);
+	return LCD_sendExtended(lcd, &ext, 1);
+}
+
+/**
+ * @brief							Writes to an address of the ICON RAM, each of which holds 5 icons (only applicable to ST7032/ST7036 controllers)
+ *
+ * The address counter of the LCD is restored afterwards, so the next character is written where it would have been otherwise
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		addr				Address in the ICON RAM (0 to LCD_EXT_ICON_COUNT-1)
+ * @param		icons				Bitmask of the icons to display at the address (only the lower 5 bits are considered)
+ *
+ * @return							Status of the transfers to the LCD (HAL_ERROR if the controller does not support it)
+ */
+HAL_StatusTypeDef LCD_setIcons(HD44780_LCD_t *lcd, uint8_t addr, uint8_t icons) {
+	if (!LCD_hasExtended(lcd) || !LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+
+	const HD44780_LCD_Shadow_t *shadow = &(lcd->shadow);
+	const uint8_t select[] = {EXT_FUNCTION | LCD_EXT_TABLE, LCD_EXT_SET_ICONADDR | (addr & (LCD_EXT_ICON_COUNT - 1))};
+	const uint8_t data = icons & 0x1F;
+	const uint8_t restore[] = {EXT_FUNCTION, ((shadow->inCGRAM) ? (LCD_SET_CGRAMADDR) : (LCD_SET_DDRAMADDR)) | shadow->addr};
+
+	HAL_StatusTypeDef status = lcd->transport->write(lcd, select, sizeof(select), 0);
+	if (status == HAL_OK) {
+		status = lcd->transport->write(lcd, &data, 1, 1);
+	}
+	if (status == HAL_OK) {
+		status = lcd->transport->write(lcd, restore, sizeof(restore), 0);
+	}
+
+	return status;
+}
+#endif
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Pages.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains page flipping, which draws the next screen into the off-screen part of the DDRAM and then shows it all at once by shifting the display
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if 2 * LCD_VISIBLE_COLS > LCD_LINE_SIZE
+#error "two pages of LCD_VISIBLE_COLS columns must fit in LCD_LINE_SIZE"
+#endif
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes the pages of an LCD with page 0 visible, returning the display home if it has been shifted
+ *
+ * Page 0 occupies the first LCD_VISIBLE_COLS columns of both lines and page 1 the next LCD_VISIBLE_COLS. The page that is not visible is drawn with
+ * LCD_drawPage and shown with LCD_flipPages. Pages rely on the display shift, so they cannot be used along with marquees or scroll tracks
+ *
+ * @param		pages				Pointer to the pages
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_initPages(HD44780_LCD_Pages_t *pages, HD44780_LCD_t *lcd) {
+	pages->lcd = lcd;
+	pages->front = 0;
+
+	if (lcd->shadow.shift != 0) {
+		return LCD_sendInstruction(lcd, LCD_SET_CURSOR_HOME);
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Writes text to the page that is not visible, sending only the characters that differ from its contents
+ *
+ * After a flip, the page that is not visible holds the screen shown before it, so redrawing a screen that changed little costs little
+ *
+ * @param		pages				Pointer to the pages
+ * @param		row					Row of the first character (0 or 1)
+ * @param		col					Column of the first character within the page (0 to LCD_VISIBLE_COLS-1)
+ * @param		buf					Pointer to the text
+ * @param		len					Number of characters (characters beyond the width of the page are ignored)
+ *
+ * @return							Status of the transfers to the LCD (the write stops at the first character that fails)
+ */
+HAL_StatusTypeDef LCD_drawPage(HD44780_LCD_Pages_t *pages, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len) {
+	HD44780_LCD_t *lcd = pages->lcd;
+	const uint32_t base = (pages->front ^ 1) * LCD_VISIBLE_COLS;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint32_t i = 0; i < len && col + i < LCD_VISIBLE_COLS && status == HAL_OK; ++i) {
+		const uint32_t phys = base + col + i;
+		const uint8_t addr = ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST)) + phys;
+
+		if (LCD_SHADOW_DDRAM_IS(lcd, row, phys, buf[i])) {
+			continue;
+		}
+
+		// the shadow buffer follows the address counter, so consecutive characters need no cursor movement
+		if (lcd->shadow.inCGRAM || lcd->shadow.addr != addr) {
+			LCD_setCursorPos(lcd, row, phys);
+		}
+		status = LCD_sendData(lcd, buf[i]);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Makes the page that is not visible visible, by shifting the display LCD_VISIBLE_COLS positions in a single streamed sequence
+ *
+ * The shifts are handed to the transport together, so they take a fraction of the refresh period of the LCD and the new page appears at once
+ *
+ * @param		pages				Pointer to the pages
+ *
+ * @return							Status of the transfer to the LCD
+ */
+HAL_StatusTypeDef LCD_flipPages(HD44780_LCD_Pages_t *pages) {
+	const uint8_t shift = LCD_SHIFT_CURSOR | ((pages->front) ? (LCD_DISPLAY_MOVE_RT) : (LCD_DISPLAY_MOVE_LT));
+	uint8_t seq[LCD_VISIBLE_COLS];
+	HAL_StatusTypeDef status;
+
+	for (uint32_t i = 0; i < LCD_VISIBLE_COLS; ++i) {
+		seq[i] = shift;
+	}
+
+	status = LCD_sendInstructions(pages->lcd, seq, LCD_VISIBLE_COLS);
+	pages->front ^= 1;
+
+	return status;
+}
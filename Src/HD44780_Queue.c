@@ -0,0 +1,272 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Queue.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the single-producer/single-consumer command queue used to post updates to the LCD from interrupt handlers
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// mask of the position of a command within the queue
+#define   QUEUE_MASK			(LCD_QUEUE_SIZE - 1)
+
+#if (LCD_QUEUE_SIZE & QUEUE_MASK) != 0 || LCD_QUEUE_SIZE > 128
+#error "LCD_QUEUE_SIZE must be a power of 2, at most 128"
+#endif
+
+// operation of a command that sends an instruction (the instruction is the first argument)
+#define   CMD_INSTRUCTION		0x00
+// operation of a command that sends data at the position of the cursor (the data is the first argument)
+#define   CMD_DATA				0x01
+// operation of a command that writes a cell (the arguments are the row, the column and the data)
+#define   CMD_CELL				0x02
+
+// encode a command into a single word (the operation in the lowest byte, followed by up to 3 arguments)
+#define   CMD_ENCODE(op, a, b, c)	((uint32_t)(op) | ((uint32_t)(a) << 8) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 24))
+// get the operation of a command
+#define   CMD_OP(cmd)			((uint8_t)(cmd))
+// get an argument of a command (0 to 2)
+#define   CMD_ARG(cmd, i)		((uint8_t)((cmd) >> (8 * ((i) + 1))))
+// mask of the part of a cell write that identifies the cell (the operation, the row and the column)
+#define   CMD_CELL_KEY			0x00FFFFFF
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Replaces a pending write to the same cell as a command, searching from the newest command and stopping at the first command that is not a cell write
+ *
+ * Commands before an instruction are not replaced, as the instruction (e.g. clearing the display) would otherwise act on the newer value
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		cmd					Encoded cell write
+ *
+ * @return							1 if a pending command was replaced, 0 otherwise
+ */
+static uint8_t LCD_coalesceCommand(HD44780_LCD_Queue_t *queue, uint32_t cmd) {
+	// the oldest command may be in the middle of being taken, so it is left alone
+	const uint8_t first = queue->tail + ((queue->taking) ? (1) : (0));
+	uint8_t pos = queue->head;
+
+	if (CMD_OP(cmd) != CMD_CELL) {
+		return 0;
+	}
+
+	while (pos != first) {
+		const uint32_t pending = queue->cmds[--pos & QUEUE_MASK];
+
+		if (CMD_OP(pending) != CMD_CELL) {
+			return 0;
+		}
+		if ((pending & CMD_CELL_KEY) == (cmd & CMD_CELL_KEY)) {
+			queue->cmds[pos & QUEUE_MASK] = cmd;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief							Adds a command to the queue, applying the policy of the queue if it is full (called only by the producer)
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		cmd					Encoded command
+ *
+ * @return							HAL_OK if the command was added or replaced a pending one, HAL_BUSY if it was dropped
+ */
+static HAL_StatusTypeDef LCD_postCommand(HD44780_LCD_Queue_t *queue, uint32_t cmd) {
+	const uint8_t head = queue->head;
+	uint8_t pending = (uint8_t) (head - queue->tail);
+
+	if (pending >= LCD_QUEUE_SIZE) {
+		if (queue->policy == queueCoalesce && LCD_coalesceCommand(queue, cmd)) {
+			++queue->stats.coalesced;
+			return HAL_OK;
+		}
+
+		// the oldest command can only be dropped while the consumer is not taking it
+		if (queue->policy != queueDropOldest || queue->taking) {
+			++queue->stats.dropped;
+			return HAL_BUSY;
+		}
+
+		queue->tail = queue->tail + 1;
+		++queue->stats.dropped;
+		--pending;
+	}
+
+	queue->cmds[head & QUEUE_MASK] = cmd;
+
+	// the command must be in the queue before the consumer can see it
+	__DMB();
+	queue->head = head + 1;
+
+	++queue->stats.posted;
+	if (pending + 1U > queue->stats.highWater) {
+		queue->stats.highWater = pending + 1U;
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Sends a command taken from the queue to the LCD
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		cmd					Encoded command
+ */
+static void LCD_executeCommand(HD44780_LCD_t *lcd, uint32_t cmd) {
+	switch (CMD_OP(cmd)) {
+	case CMD_INSTRUCTION:
+		LCD_sendInstruction(lcd, CMD_ARG(cmd, 0));
+		break;
+
+	case CMD_DATA:
+		LCD_sendData(lcd, CMD_ARG(cmd, 0));
+		break;
+
+	case CMD_CELL:
+		LCD_setCursorPos(lcd, CMD_ARG(cmd, 0), CMD_ARG(cmd, 1));
+		LCD_sendData(lcd, CMD_ARG(cmd, 2));
+		break;
+
+	default:
+		break;
+	}
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a command queue, through which commands are posted (e.g. from an interrupt handler) and later sent to the LCD by LCD_drainQueue
+ *
+ * Only one context may post to a queue, and only one context may drain it (interrupt handlers of the same priority cannot interrupt each other, and
+ * count as one context). With queueDropOldest and queueCoalesce, the queue must be drained at a priority no higher than it is posted to, e.g. from the main loop
+ *
+ * @param		queue				Pointer to the command queue (usually statically allocated)
+ * @param		lcd					Pointer to LCD structure, which must be initialized before the queue is drained
+ * @param		policy				What is done with a command posted to a full queue
+ */
+void LCD_initQueue(HD44780_LCD_Queue_t *queue, HD44780_LCD_t *lcd, enum HD44780_LCD_QUEUE_POLICY policy) {
+	queue->lcd = lcd;
+	queue->head = 0;
+	queue->tail = 0;
+	queue->taking = 0;
+	queue->policy = policy;
+
+	queue->stats.posted = 0;
+	queue->stats.executed = 0;
+	queue->stats.dropped = 0;
+	queue->stats.coalesced = 0;
+	queue->stats.highWater = 0;
+}
+
+/**
+ * @brief							Posts a single-byte instruction with the parameter bitmask to the queue, which never blocks
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		instruction			Instruction with parameter bitmask
+ *
+ * @return							HAL_OK if the command was posted, HAL_BUSY if it was dropped
+ */
+HAL_StatusTypeDef LCD_postInstruction(HD44780_LCD_Queue_t *queue, uint8_t instruction) {
+	return LCD_postCommand(queue, CMD_ENCODE(CMD_INSTRUCTION, instruction, 0, 0));
+}
+
+/**
+ * @brief							Posts a single byte of data to the queue, which is written at the position of the cursor when it is sent, and never blocks
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		data				Data to send
+ *
+ * @return							HAL_OK if the command was posted, HAL_BUSY if it was dropped
+ */
+HAL_StatusTypeDef LCD_postData(HD44780_LCD_Queue_t *queue, uint8_t data) {
+	return LCD_postCommand(queue, CMD_ENCODE(CMD_DATA, data, 0, 0));
+}
+
+/**
+ * @brief							Posts a write of a single cell to the queue, which never blocks (the cursor is left after the cell when it is sent)
+ *
+ * With queueCoalesce, a write posted to a full queue replaces a pending write to the same cell, so only the latest value is sent
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		row					Row of the cell (0 or 1)
+ * @param		col					Column of the cell (0 to LCD_LINE_SIZE-1)
+ * @param		data				Data to write to the cell
+ *
+ * @return							HAL_OK if the command was posted or replaced a pending one, HAL_BUSY if it was dropped
+ */
+HAL_StatusTypeDef LCD_postCell(HD44780_LCD_Queue_t *queue, uint8_t row, uint8_t col, uint8_t data) {
+	return LCD_postCommand(queue, CMD_ENCODE(CMD_CELL, row, col, data));
+}
+
+/**
+ * @brief							Posts writes of consecutive cells of a row to the queue, one command per cell, which never blocks
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		row					Row of the first cell (0 or 1)
+ * @param		col					Column of the first cell
+ * @param		buf					Pointer to the data to write to the cells
+ * @param		len					Number of cells
+ *
+ * @return							HAL_OK if every command was posted, HAL_BUSY if any of them was dropped
+ */
+HAL_StatusTypeDef LCD_postField(HD44780_LCD_Queue_t *queue, uint8_t row, uint8_t col, const uint8_t *buf, uint32_t len) {
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for (uint32_t i = 0; i < len; ++i) {
+		if (LCD_postCommand(queue, CMD_ENCODE(CMD_CELL, row, col + i, buf[i])) != HAL_OK) {
+			status = HAL_BUSY;
+		}
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Sends the commands pending in the queue to the LCD, in the order they were posted, and must be called periodically (e.g. from the main loop or a timer interrupt)
+ *
+ * @param		queue				Pointer to the command queue
+ * @param		max					Maximum number of commands to send, which bounds the time spent
+ *
+ * @return							Number of commands that were sent
+ */
+uint32_t LCD_drainQueue(HD44780_LCD_Queue_t *queue, uint32_t max) {
+	uint32_t count = 0;
+
+	while (count < max && queue->tail != queue->head) {
+		uint8_t tail;
+		uint32_t cmd;
+
+		// the producer does not drop or replace the oldest command while it is being taken
+		queue->taking = 1;
+		__DMB();
+		tail = queue->tail;
+		cmd = queue->cmds[tail & QUEUE_MASK];
+		queue->tail = tail + 1;
+		__DMB();
+		queue->taking = 0;
+
+		LCD_executeCommand(queue->lcd, cmd);
+		++count;
+	}
+
+	queue->stats.executed += count;
+	return count;
+}
+
+/**
+ * @brief							Returns the statistics of a command queue
+ *
+ * @param		queue				Pointer to the command queue
+ *
+ * @return							Pointer to the statistics of the queue
+ */
+const HD44780_LCD_QueueStats_t *LCD_getQueueStats(const HD44780_LCD_Queue_t *queue) {
+	return &(queue->stats);
+}
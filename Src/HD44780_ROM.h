@@ -0,0 +1,112 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_ROM.h
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the tables of the character ROMs by code point, shared by the UTF-8 text path and the compile-time encoders of the C++ front end
+ ******************************************************************************
+ */
+
+#ifndef HD44780_ROM_H_
+#define HD44780_ROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// the tables are constant expressions in C++, so that text can be encoded at compile time (in C, only one translation unit includes them)
+#ifdef __cplusplus
+#define   LCD_ROM_CONSTEXPR		constexpr
+#else
+#define   LCD_ROM_CONSTEXPR
+#endif
+
+/** Character ROMs -----------------------------------------------------------*/
+
+// characters of the A00 (Japanese) ROM by code point, from U+0000 to U+007F (0 where the ROM does not have the character)
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA00Basic[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x00, 0x5D, 0x5E, 0x5F,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x00, 0x00
+};
+
+// characters of the A00 ROM from U+0080 to U+00FF
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA00Latin1[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x20, 0x00, 0xEC, 0xED, 0x00, 0x5C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xDF, 0x00, 0x00, 0x00, 0x00, 0xE4, 0x00, 0xA5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xE1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0xEE, 0x00, 0x00, 0x00, 0x00, 0xEF, 0xFD, 0x00, 0x00, 0x00, 0x00, 0xF5, 0x00, 0x00, 0x00
+};
+
+// characters of the A00 ROM from U+0380 to U+03FF (Greek capitals that look like Latin ones are shown as those)
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA00Greek[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x41, 0x42, 0x00, 0x00, 0x45, 0x5A, 0x48, 0x00, 0x49, 0x4B, 0x00, 0x4D, 0x4E, 0x00, 0x4F,
+	0x00, 0x50, 0x00, 0xF6, 0x54, 0x59, 0x00, 0x58, 0x00, 0xF4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0xE0, 0xE2, 0x00, 0x00, 0xE3, 0x00, 0x00, 0xF2, 0x00, 0x00, 0x00, 0xE4, 0x00, 0x00, 0x6F,
+	0xF7, 0xE6, 0x00, 0xE5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// characters of the A02 (European) ROM from U+0000 to U+007F
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA02Basic[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x00
+};
+
+// characters of the A02 ROM from U+0080 to U+00FF
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA02Latin1[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x20, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0x00, 0xA9, 0xAA, 0xAB, 0x00, 0x00, 0xAE, 0x00,
+	0xB0, 0xB1, 0xB2, 0xB3, 0x00, 0xB5, 0xB6, 0xB7, 0x00, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,
+	0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+	0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
+	0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF
+};
+
+// characters of the A02 ROM from U+0380 to U+03FF
+static LCD_ROM_CONSTEXPR const uint8_t LCD_romA02Greek[128] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x41, 0x42, 0x92, 0x00, 0x45, 0x5A, 0x48, 0x99, 0x49, 0x4B, 0x00, 0x4D, 0x4E, 0x00, 0x4F,
+	0x00, 0x50, 0x00, 0x94, 0x54, 0x59, 0x00, 0x58, 0x00, 0x9A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x90, 0x00, 0x00, 0x9B, 0x9E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xB5, 0x00, 0x00, 0x6F,
+	0x93, 0x00, 0x00, 0x95, 0x97, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// pages of 128 code points from U+0000 to U+03FF of each ROM (NULL where the ROM has none of the characters of the page)
+static LCD_ROM_CONSTEXPR const uint8_t *const LCD_romPages[2][8] = {
+	{ LCD_romA00Basic, LCD_romA00Latin1, NULL, NULL, NULL, NULL, NULL, LCD_romA00Greek },
+	{ LCD_romA02Basic, LCD_romA02Latin1, NULL, NULL, NULL, NULL, NULL, LCD_romA02Greek }
+};
+
+// characters of each ROM beyond U+03FF, other than the halfwidth katakana of the A00 ROM
+static LCD_ROM_CONSTEXPR const struct {
+	uint16_t codePoint;
+	uint8_t code;
+} LCD_romSymbols[2][4] = {
+	{ { 0x2190, 0x7F }, { 0x2192, 0x7E }, { 0x221A, 0xE8 }, { 0x221E, 0xF3 } },
+	{ { 0x221E, 0x9C }, { 0x2302, 0x7F }, { 0x2665, 0x9D }, { 0x266A, 0x91 } }
+};
+
+#endif /* HD44780_ROM_H_ */
@@ -0,0 +1,280 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_RTOS.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the display task, which owns an LCD and serves requests from other tasks when the library runs along with a CMSIS-RTOS2 kernel
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+#if LCD_USE_CMSIS_RTOS2
+
+// request that sends an instruction (the instruction is the first byte of the text)
+#define   REQ_INSTRUCTION		0x00
+// request that writes text starting at a position
+#define   REQ_TEXT				0x01
+// request that calls a function with the LCD
+#define   REQ_CALL				0x02
+// request that sets LCD_RTOS_SYNC_FLAG on the task that made it
+#define   REQ_SYNC				0x03
+
+// the number of ticks the display task waits for a request while the LCD is offline, before it services the link again
+#define   OFFLINE_POLL_TICKS	((LCD_I2C_PROBE_INTERVAL * osKernelGetTickFreq() + 999U) / 1000U)
+
+typedef struct HD44780_LCD_Request_t {
+	uint8_t op;						// what the display task does (one of REQ_*)
+	uint8_t row;					// row of the first character of the text
+	uint8_t col;					// column of the first character of the text
+	uint8_t len;					// number of characters of the text
+	union {
+		uint8_t text[LCD_RTOS_TEXT_LEN];					// text written to the LCD
+		struct {
+			void (*fn)(HD44780_LCD_t *lcd, void *arg);		// function called with the LCD
+			void *arg;										// argument passed to the function
+		};
+		osThreadId_t thread;								// task waiting for the request to be handled
+	};
+} HD44780_LCD_Request_t;
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Converts the status of a CMSIS-RTOS2 call into the status returned by the library
+ *
+ * @param		status				Status of the call
+ *
+ * @return							HAL_OK, HAL_TIMEOUT if the call timed out, HAL_ERROR otherwise
+ */
+static HAL_StatusTypeDef LCD_fromOsStatus(osStatus_t status) {
+	if (status == osOK) {
+		return HAL_OK;
+	}
+	if (status == osErrorTimeout || status == osErrorResource) {
+		return HAL_TIMEOUT;
+	}
+
+	return HAL_ERROR;
+}
+
+/**
+ * @brief							Handles a request made to the display task
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		req					Pointer to the request
+ */
+static void LCD_handleRequest(HD44780_LCD_t *lcd, const HD44780_LCD_Request_t *req) {
+	switch (req->op) {
+	case REQ_INSTRUCTION:
+		LCD_sendInstruction(lcd, req->text[0]);
+		break;
+
+	case REQ_TEXT:
+		LCD_setCursorPos(lcd, req->row, req->col);
+		LCD_sendBuffer(lcd, req->text, req->len);
+		break;
+
+	case REQ_CALL:
+		req->fn(lcd, req->arg);
+		break;
+
+	case REQ_SYNC:
+		osThreadFlagsSet(req->thread, LCD_RTOS_SYNC_FLAG);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief							Body of the display task, which initializes the LCD and then handles requests in the order they were made
+ *
+ * @param		argument			Pointer to the service of the task
+ */
+static void LCD_serviceTask(void *argument) {
+	HD44780_LCD_Service_t *service = (HD44780_LCD_Service_t *) argument;
+	HD44780_LCD_Request_t req;
+
+	service->initStatus = LCD_init(service->lcd);
+
+	for (;;) {
+		uint32_t timeout = osWaitForever;
+
+		// an LCD being re-attached is stepped every tick, and one that is offline every probe interval
+		if (service->lcd->I2CLink == linkOffline) {
+			timeout = OFFLINE_POLL_TICKS;
+		} else if (service->lcd->I2CLink != linkOnline) {
+			timeout = 1U;
+		}
+
+		if (osMessageQueueGet(service->queue, &req, NULL, timeout) == osOK) {
+			LCD_handleRequest(service->lcd, &req);
+		}
+
+#if LCD_USE_I2C
+		// an LCD driven via I2C that went offline is re-attached between requests
+		LCD_serviceI2C(service->lcd);
+#endif
+	}
+}
+
+/**
+ * @brief							Adds a request to the queue of the display task
+ *
+ * @param		service				Pointer to the service
+ * @param		req					Pointer to the request (copied into the queue)
+ * @param		timeout				Number of ticks to wait for space in the queue (must be 0 in interrupt handlers)
+ *
+ * @return							HAL_OK if the request was queued, HAL_TIMEOUT if the queue stayed full, HAL_ERROR otherwise
+ */
+static HAL_StatusTypeDef LCD_request(HD44780_LCD_Service_t *service, const HD44780_LCD_Request_t *req, uint32_t timeout) {
+	return LCD_fromOsStatus(osMessageQueuePut(service->queue, req, 0U, timeout));
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Creates the display task, which initializes the LCD and becomes its only user, along with the queue of requests made to it
+ *
+ * The LCD must be created (e.g. with LCD_createI2C) but not initialized, and must only be used through the request functions afterwards. The waits of
+ * the display task sleep instead of busy-waiting, so other tasks run while the LCD executes instructions
+ *
+ * @param		service				Pointer to the service (must remain valid while the task runs)
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							HAL_OK if the task and its queue were created, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_startService(HD44780_LCD_Service_t *service, HD44780_LCD_t *lcd) {
+	const osThreadAttr_t attr = {
+		.name = "LCD",
+		.stack_size = LCD_RTOS_STACK_SIZE,
+		.priority = LCD_RTOS_PRIORITY
+	};
+
+	service->lcd = lcd;
+	service->initStatus = HAL_BUSY;
+
+	service->queue = osMessageQueueNew(LCD_RTOS_QUEUE_LEN, sizeof(HD44780_LCD_Request_t), NULL);
+	if (service->queue == NULL) {
+		return HAL_ERROR;
+	}
+
+	service->thread = osThreadNew(LCD_serviceTask, service, &attr);
+	if (service->thread == NULL) {
+		osMessageQueueDelete(service->queue);
+		return HAL_ERROR;
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Requests the display task to send a single-byte instruction with the parameter bitmask to the LCD
+ *
+ * @param		service				Pointer to the service
+ * @param		instruction			Instruction with parameter bitmask
+ * @param		timeout				Number of ticks to wait for space in the queue (must be 0 in interrupt handlers)
+ *
+ * @return							HAL_OK if the request was queued, HAL_TIMEOUT if the queue stayed full, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_requestInstruction(HD44780_LCD_Service_t *service, uint8_t instruction, uint32_t timeout) {
+	HD44780_LCD_Request_t req;
+
+	req.op = REQ_INSTRUCTION;
+	req.text[0] = instruction;
+
+	return LCD_request(service, &req, timeout);
+}
+
+/**
+ * @brief							Requests the display task to write text starting at a position of the LCD
+ *
+ * Text longer than LCD_RTOS_TEXT_LEN characters is split into several requests, between which requests from other tasks may be handled
+ *
+ * @param		service				Pointer to the service
+ * @param		row					Row of the first character (0 or 1)
+ * @param		col					Column of the first character
+ * @param		buf					Pointer to the text (copied into the queue)
+ * @param		len					Number of characters
+ * @param		timeout				Number of ticks to wait for space in the queue for each request (must be 0 in interrupt handlers)
+ *
+ * @return							HAL_OK if every request was queued, otherwise the status of the first that was not (the rest are not made)
+ */
+HAL_StatusTypeDef LCD_requestText(HD44780_LCD_Service_t *service, uint8_t row, uint8_t col,
+		const uint8_t *buf, uint32_t len, uint32_t timeout) {
+	HAL_StatusTypeDef status = HAL_OK;
+	HD44780_LCD_Request_t req;
+
+	req.op = REQ_TEXT;
+	req.row = row;
+
+	for (uint32_t pos = 0; pos < len && status == HAL_OK; pos += req.len) {
+		req.col = col + pos;
+		req.len = ((len - pos) < LCD_RTOS_TEXT_LEN) ? (len - pos) : (LCD_RTOS_TEXT_LEN);
+
+		for (uint32_t i = 0; i < req.len; ++i) {
+			req.text[i] = buf[pos + i];
+		}
+
+		status = LCD_request(service, &req, timeout);
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Requests the display task to call a function with the LCD, which allows any function of the library to be used from other tasks
+ *
+ * @param		service				Pointer to the service
+ * @param		fn					Function called by the display task with the LCD and the argument
+ * @param		arg					Argument passed to the function (must remain valid until it is called)
+ * @param		timeout				Number of ticks to wait for space in the queue (must be 0 in interrupt handlers)
+ *
+ * @return							HAL_OK if the request was queued, HAL_TIMEOUT if the queue stayed full, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_requestCall(HD44780_LCD_Service_t *service, void (*fn)(HD44780_LCD_t *lcd, void *arg),
+		void *arg, uint32_t timeout) {
+	HD44780_LCD_Request_t req;
+
+	req.op = REQ_CALL;
+	req.fn = fn;
+	req.arg = arg;
+
+	return LCD_request(service, &req, timeout);
+}
+
+/**
+ * @brief							Waits until the display task has handled every request the calling task made before (must not be called from interrupt handlers)
+ *
+ * @param		service				Pointer to the service
+ * @param		timeout				Number of ticks to wait for, in total
+ *
+ * @return							HAL_OK once the earlier requests were handled, HAL_TIMEOUT if they were not handled in time, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef LCD_requestSync(HD44780_LCD_Service_t *service, uint32_t timeout) {
+	HD44780_LCD_Request_t req;
+	HAL_StatusTypeDef status;
+	uint32_t flags;
+
+	req.op = REQ_SYNC;
+	req.thread = osThreadGetId();
+
+	osThreadFlagsClear(LCD_RTOS_SYNC_FLAG);
+	status = LCD_request(service, &req, timeout);
+	if (status != HAL_OK) {
+		return status;
+	}
+
+	flags = osThreadFlagsWait(LCD_RTOS_SYNC_FLAG, osFlagsWaitAny, timeout);
+	if (flags == (uint32_t) osErrorTimeout) {
+		return HAL_TIMEOUT;
+	}
+
+	return ((flags & osFlagsError) == 0U) ? (HAL_OK) : (HAL_ERROR);
+}
+
+#endif
@@ -0,0 +1,371 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Screen.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the compiled screens, which encode the whole visible DDRAM once into the stream of a transport, so it is replayed in a single transfer
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// the number of bytes a screen sends to the LCD (an address instruction and the visible columns of each row)
+#define   SCREEN_BYTES			(2 * (1 + LCD_VISIBLE_COLS))
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Returns a byte that a screen sends to the LCD
+ *
+ * @param		cells				Codes of the cells of the screen
+ * @param		index				Index of the byte (0 to SCREEN_BYTES - 1)
+ * @param		isData				Whether the byte is an instruction (0) or Data (1), written by the function
+ *
+ * @return							Byte sent to the LCD
+ */
+static uint8_t LCD_screenByte(const uint8_t *cells, uint32_t index, uint8_t *isData) {
+	const uint32_t row = index / (1 + LCD_VISIBLE_COLS);
+	const uint32_t col = index % (1 + LCD_VISIBLE_COLS);
+
+	*isData = (col != 0);
+	if (col == 0) {
+		return LCD_SET_DDRAMADDR | ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST));
+	}
+
+	return cells[row * LCD_VISIBLE_COLS + col - 1];
+}
+
+/**
+ * @brief							Returns how a screen of an LCD is replayed, according to its transport
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							How the screen is replayed (screenNone if the transport cannot replay a stream)
+ */
+static enum HD44780_LCD_SCREEN LCD_screenKind(const HD44780_LCD_t *lcd) {
+#if LCD_USE_I2C
+	if (lcd->transport == &LCD_PCF8574) {
+		return screenI2C;
+	}
+#endif
+#if LCD_USE_GPIO
+	// the stream is written to the BSRR register of a single port, so every pin must be on the port of EN
+	if (lcd->transport == &LCD_GPIO_HALF_BUS || lcd->transport == &LCD_GPIO_FULL_BUS) {
+		const uint32_t pins = (lcd->transport == &LCD_GPIO_HALF_BUS) ? (4) : (8);
+
+		if (lcd->rsPin.port != lcd->enPin.port) {
+			return screenNone;
+		}
+		for (uint32_t i = 0; i < pins; ++i) {
+			if (lcd->dataPins[i].port != lcd->enPin.port) {
+				return screenNone;
+			}
+		}
+
+		return screenGPIO;
+	}
+#endif
+
+	(void) lcd;
+	return screenNone;
+}
+
+#if LCD_USE_GPIO
+/**
+ * @brief							Returns the number of words of a stream for GPIO Pins left blank after each byte, so the next one is written once the LCD has executed it
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Number of blank words
+ */
+static uint32_t LCD_screenPadding(const HD44780_LCD_t *lcd) {
+	const uint32_t ticks = (lcd->variant->execUs + LCD_SCREEN_TICK_US - 1) / LCD_SCREEN_TICK_US;
+
+	// EN rises again two words after it falls (the data of the next byte is written in between)
+	return (ticks > 2) ? (ticks - 2) : (0);
+}
+
+/**
+ * @brief							Compiles a screen into the words written to the BSRR register of the port of the GPIO Pins of the LCD
+ *
+ * Each nibble (or byte in 8-bit mode) takes three words: RS and the data pins with EN low, EN high and EN low again. Blank words (which change no pin)
+ * follow each byte until the LCD has executed it
+ *
+ * @param		screen				Pointer to the screen
+ *
+ * @return							Length of the stream in bytes
+ */
+static uint32_t LCD_compileScreenGPIO(HD44780_LCD_Screen_t *screen) {
+	const HD44780_LCD_t *lcd = screen->lcd;
+	const uint32_t enMask = LCD_PIN_MASK(lcd->enPin);
+	const uint32_t halfBus = (lcd->transport == &LCD_GPIO_HALF_BUS);
+	const uint32_t padding = LCD_screenPadding(lcd);
+	uint32_t *words = (uint32_t *) screen->buf;
+	uint32_t len = 0;
+
+	for (uint32_t i = 0; i < SCREEN_BYTES; ++i) {
+		uint8_t isData;
+		const uint8_t byte = LCD_screenByte(screen->cells, i, &isData);
+
+		for (uint32_t part = 0; part < ((halfBus) ? (2) : (1)); ++part) {
+			const uint8_t value = (!halfBus) ? (byte) : (part == 0) ? (HI_NIBBLE(byte)) : (LO_NIBBLE(byte));
+			uint32_t word = (enMask << 16) | ((uint32_t) LCD_PIN_MASK(lcd->rsPin) << ((isData) ? (0) : (16)));
+
+			for (uint32_t pin = 0; pin < ((halfBus) ? (4) : (8)); ++pin) {
+				word |= (uint32_t) LCD_PIN_MASK(lcd->dataPins[pin]) << (((value >> pin) & 1) ? (0) : (16));
+			}
+
+			words[len++] = word;
+			words[len++] = enMask;
+			words[len++] = enMask << 16;
+		}
+
+		for (uint32_t k = 0; k < padding; ++k) {
+			words[len++] = 0;
+		}
+	}
+
+	return len * sizeof(uint32_t);
+}
+#endif
+
+#if LCD_USE_I2C
+/**
+ * @brief							Compiles a screen into the frames sent to the PC8574 Expander of the LCD (each nibble with EN low, high and low again)
+ *
+ * @param		screen				Pointer to the screen
+ *
+ * @return							Number of bytes of the stream
+ */
+static uint32_t LCD_compileScreenI2C(HD44780_LCD_Screen_t *screen) {
+	const HD44780_LCD_t *lcd = screen->lcd;
+	const uint8_t enMask = 1 << lcd->expanderPins.en;
+	uint8_t *frames = (uint8_t *) screen->buf;
+	uint32_t len = 0;
+
+	for (uint32_t i = 0; i < SCREEN_BYTES; ++i) {
+		uint8_t isData;
+		const uint8_t byte = LCD_screenByte(screen->cells, i, &isData);
+
+		for (uint32_t part = 0; part < 2; ++part) {
+			const uint8_t value = LCD_I2C_NIBBLE(lcd, isData, (part == 0) ? (HI_NIBBLE(byte)) : (LO_NIBBLE(byte)));
+
+			frames[len++] = value;
+			frames[len++] = value | enMask;
+			frames[len++] = value;
+		}
+	}
+
+	return len;
+}
+#endif
+
+/**
+ * @brief							Returns whether the stream of a screen matches the LCD as it is now driven
+ *
+ * @param		screen				Pointer to the screen
+ *
+ * @return							1 if the stream can be replayed, 0 if it must be compiled again
+ */
+static uint8_t LCD_isScreenCurrent(const HD44780_LCD_Screen_t *screen) {
+	const HD44780_LCD_t *lcd = screen->lcd;
+
+	if (screen->kind != LCD_screenKind(lcd) || screen->len != LCD_screenSize(lcd)) {
+		return 0;
+	}
+
+#if LCD_USE_I2C
+	// the first nibble is enough to tell whether the frames were encoded with the pin map and the backlight of the LCD
+	if (screen->kind == screenI2C) {
+		const uint8_t *frames = (const uint8_t *) screen->stream;
+		const uint8_t first = LCD_I2C_NIBBLE(lcd, 0, HI_NIBBLE(LCD_SET_DDRAMADDR));
+
+		return frames[0] == first && frames[1] == (first | (1 << lcd->expanderPins.en));
+	}
+#endif
+
+	return 1;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Returns the size of the buffer that a screen of an LCD is compiled into
+ *
+ * @param		lcd					Pointer to LCD structure
+ *
+ * @return							Size in bytes (6 per byte sent for a PC8574 Expander, a multiple of 4 for GPIO Pins), 0 if the transport of the LCD cannot replay a screen
+ */
+uint32_t LCD_screenSize(const HD44780_LCD_t *lcd) {
+	switch (LCD_screenKind(lcd)) {
+#if LCD_USE_I2C
+	case screenI2C:
+		return SCREEN_BYTES * 6;
+#endif
+#if LCD_USE_GPIO
+	case screenGPIO:
+		return SCREEN_BYTES * (((lcd->transport == &LCD_GPIO_HALF_BUS) ? (6) : (3)) + LCD_screenPadding(lcd)) * sizeof(uint32_t);
+#endif
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief							Compiles a screen into a buffer in RAM, as the stream that its transport replays in a single transfer
+ *
+ * The stream sets the address of each row and writes the first LCD_VISIBLE_COLS columns of both lines of the DDRAM, which are the visible ones unless
+ * the display is shifted. A screen that cannot be compiled (e.g. the transport is not a PC8574 Expander or GPIO Pins on a single port, or the buffer is
+ * too small) is still shown by LCD_showScreen, which then writes its cells through the transport
+ *
+ * @param		screen				Pointer to the screen
+ * @param		lcd					Pointer to LCD structure
+ * @param		cells				Codes of the cells, LCD_VISIBLE_COLS of the first row followed by those of the second (must remain valid while the screen is used)
+ * @param		buf					Pointer to the buffer (aligned to 4 bytes)
+ * @param		size				Size of the buffer in bytes (at least LCD_screenSize)
+ *
+ * @return							HAL_OK, HAL_ERROR if the screen cannot be compiled
+ */
+HAL_StatusTypeDef LCD_compileScreen(HD44780_LCD_Screen_t *screen, HD44780_LCD_t *lcd, const uint8_t *cells, void *buf, uint32_t size) {
+	const uint32_t need = LCD_screenSize(lcd);
+
+	screen->lcd = lcd;
+	screen->cells = cells;
+	screen->stream = buf;
+	screen->buf = buf;
+	screen->size = size;
+	screen->len = 0;
+	screen->kind = screenNone;
+
+	if (need == 0 || need > size) {
+		return HAL_ERROR;
+	}
+
+	screen->kind = LCD_screenKind(lcd);
+
+#if LCD_USE_I2C
+	if (screen->kind == screenI2C) {
+		screen->len = LCD_compileScreenI2C(screen);
+	}
+#endif
+#if LCD_USE_GPIO
+	if (screen->kind == screenGPIO) {
+		screen->len = LCD_compileScreenGPIO(screen);
+	}
+#endif
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Initializes a screen whose stream was compiled at build time (e.g. by hd44780::pcf8574Screen) and placed in flash
+ *
+ * The stream cannot be compiled again, so if it does not match the LCD (e.g. its backlight is in the other state), LCD_showScreen writes the cells
+ * through the transport instead
+ *
+ * @param		screen				Pointer to the screen
+ * @param		lcd					Pointer to LCD structure
+ * @param		cells				Codes of the cells, LCD_VISIBLE_COLS of the first row followed by those of the second
+ * @param		stream				Pointer to the frames of the PC8574 Expander
+ * @param		len					Number of bytes of the frames
+ */
+void LCD_initCompiledScreen(HD44780_LCD_Screen_t *screen, HD44780_LCD_t *lcd, const uint8_t *cells, const uint8_t *stream, uint32_t len) {
+	screen->lcd = lcd;
+	screen->cells = cells;
+	screen->stream = stream;
+	screen->buf = NULL;
+	screen->size = 0;
+	screen->len = len;
+	screen->kind = screenI2C;
+}
+
+/**
+ * @brief							Prepares the LCD for the stream of a screen to be replayed, e.g. by DMA
+ *
+ * A stream in RAM that no longer matches the LCD is compiled again, and the cursor is set to move right if it does not already. Once this returns
+ * HAL_OK, the stream (screen->stream, screen->len bytes) can be sent to the I2C Expander, or written to the BSRR register of the port of the pins
+ * one word every LCD_SCREEN_TICK_US microseconds. LCD_trackScreen must then be called, before anything else is sent to the LCD
+ *
+ * @param		screen				Pointer to the screen
+ *
+ * @return							HAL_OK, HAL_ERROR if the stream cannot be replayed (or the LCD is offline)
+ */
+HAL_StatusTypeDef LCD_prepareScreen(HD44780_LCD_Screen_t *screen) {
+	HD44780_LCD_t *lcd = screen->lcd;
+
+	if (screen->kind == screenNone || !LCD_isOnline(lcd)) {
+		return HAL_ERROR;
+	}
+
+	if (!LCD_isScreenCurrent(screen)) {
+		if (screen->buf == NULL || LCD_compileScreen(screen, lcd, screen->cells, screen->buf, screen->size) != HAL_OK) {
+			return HAL_ERROR;
+		}
+	}
+
+	// the stream writes each row with the address counter moving right
+	if (lcd->cursorMovement != (LCD_CURSOR_MOVE | LCD_CURSOR_POS_INC)) {
+		LCD_setCursorAutoInc(lcd);
+	}
+
+	return HAL_OK;
+}
+
+/**
+ * @brief							Shows a screen by replaying its stream in a single transfer, or by writing its cells through the transport if the stream cannot be replayed
+ *
+ * The shadow buffer is updated, so fields that change afterwards are written over the screen through the rest of the library, which sends only them
+ *
+ * @param		screen				Pointer to the screen
+ *
+ * @return							Status of the transfers to the LCD
+ */
+HAL_StatusTypeDef LCD_showScreen(HD44780_LCD_Screen_t *screen) {
+	HD44780_LCD_t *lcd = screen->lcd;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	if (LCD_prepareScreen(screen) != HAL_OK) {
+		for (uint32_t row = 0; row < 2 && status == HAL_OK; ++row) {
+			LCD_setCursorPos(lcd, row, 0);
+			status = LCD_sendBuffer(lcd, &(screen->cells[row * LCD_VISIBLE_COLS]), LCD_VISIBLE_COLS);
+		}
+		return status;
+	}
+
+	LCD_trackScreen(screen);
+
+#if LCD_USE_I2C
+	if (screen->kind == screenI2C) {
+		status = LCD_transmitI2C(lcd, (uint8_t *) screen->stream, screen->len);
+	}
+#endif
+#if LCD_USE_GPIO
+	if (screen->kind == screenGPIO) {
+		const uint32_t *words = (const uint32_t *) screen->stream;
+		GPIO_TypeDef *port = LCD_PIN_PORT(lcd->enPin);
+
+		for (uint32_t i = 0; i < screen->len / sizeof(uint32_t); ++i) {
+			port->BSRR = words[i];
+			LCD_delayUs(LCD_SCREEN_TICK_US);
+		}
+	}
+#endif
+
+	return status;
+}
+
+/**
+ * @brief							Updates the shadow buffer of the LCD with a screen whose stream was replayed without the library (e.g. by DMA)
+ *
+ * @param		screen				Pointer to the screen
+ */
+void LCD_trackScreen(HD44780_LCD_Screen_t *screen) {
+	for (uint32_t row = 0; row < 2; ++row) {
+		const uint8_t instruction = LCD_SET_DDRAMADDR | ((row) ? (LCD_ORIG_ADDR_SECOND) : (LCD_ORIG_ADDR_FIRST));
+
+		LCD_trackTransfer(screen->lcd, &instruction, 1, 0);
+		LCD_trackTransfer(screen->lcd, &(screen->cells[row * LCD_VISIBLE_COLS]), LCD_VISIBLE_COLS, 1);
+	}
+}
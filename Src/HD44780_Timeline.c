@@ -0,0 +1,297 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Timeline.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the timeline, which steps animations of the LCD (revealing text, scrolling, swapping glyphs and blinking) as they become due
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// whether a tick has been reached (ticks wrap around, so they are compared by their difference)
+#define   TICK_REACHED(now, tick)	((int32_t)((now) - (tick)) >= 0)
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Initializes the fields shared by every kind of track
+ *
+ * @param		track				Pointer to the track
+ * @param		kind				What the track animates (one of HD44780_LCD_TRACK)
+ * @param		steps				Number of steps after which the track ends (0 to repeat forever)
+ * @param		period				Number of ticks between steps
+ */
+static void LCD_initTrack(HD44780_LCD_Track_t *track, enum HD44780_LCD_TRACK kind, uint16_t steps, uint32_t period) {
+	track->next = NULL;
+	track->data = NULL;
+	track->period = period;
+	track->due = 0;
+	track->step = 0;
+	track->steps = steps;
+	track->kind = kind;
+	track->arg = 0;
+	track->row = 0;
+	track->col = 0;
+	track->len = 0;
+	track->running = 0;
+}
+
+/**
+ * @brief							Sends the bus operations of the next step of a track
+ *
+ * @param		lcd					Pointer to LCD structure
+ * @param		track				Pointer to the track
+ */
+static void LCD_stepTrack(HD44780_LCD_t *lcd, const HD44780_LCD_Track_t *track) {
+	switch (track->kind) {
+	case trackReveal:
+		LCD_setCursorPos(lcd, track->row, track->col + track->step);
+		LCD_sendData(lcd, track->data[track->step]);
+		break;
+
+	case trackScroll:
+		if (track->arg) {
+			LCD_scrollDisplayRight(lcd);
+		} else {
+			LCD_scrollDisplayLeft(lcd);
+		}
+		break;
+
+	case trackGlyph: {
+		const uint8_t inCGRAM = lcd->shadow.inCGRAM;
+		const uint8_t addr = lcd->shadow.addr;
+
+		// only the rows that differ from the previous glyph are sent, and the address counter is returned to the DDRAM afterwards, so text
+		// written after the step continues from where the cursor was (the glyph costs at most 9 bytes, however many cells show it)
+		LCD_updateCustomChar(lcd, track->arg, &track->data[track->step * 8]);
+		if (!inCGRAM && lcd->shadow.inCGRAM) {
+			LCD_sendInstruction(lcd, LCD_SET_DDRAMADDR | addr);
+		}
+		break;
+	}
+
+	case trackBlink:
+		LCD_setCursorPos(lcd, track->row, track->col);
+
+		// even steps hide the text and odd steps show it again
+		if (track->step & 1) {
+			LCD_sendBuffer(lcd, track->data, track->len);
+		} else {
+			for (uint32_t i = 0; i < track->len; ++i) {
+				LCD_sendData(lcd, ' ');
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief							Returns whether a track has nothing to animate (a reveal track without characters, or a glyph track without glyphs)
+ *
+ * A reveal track of 0 characters would otherwise take 0 steps, which means it repeats forever, and read past its text
+ *
+ * @param		track				Pointer to the track
+ *
+ * @return							1 if the track must not be started, 0 otherwise
+ */
+static uint8_t LCD_isEmptyTrack(const HD44780_LCD_Track_t *track) {
+	return (track->kind == trackReveal || track->kind == trackGlyph) && track->len == 0;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Initializes a timeline without any tracks
+ *
+ * Tracks are started on the timeline with LCD_startTrack, and LCD_tick steps those that are due. The tracks write to the LCD and move its cursor,
+ * so LCD_tick, LCD_startTrack and LCD_stopTrack must be called from the same context that uses the LCD (e.g. the main loop)
+ *
+ * @param		timeline			Pointer to the timeline (usually statically allocated)
+ * @param		lcd					Pointer to LCD structure, which must be initialized before the timeline is ticked
+ */
+void LCD_initTimeline(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_t *lcd) {
+	timeline->lcd = lcd;
+	timeline->tracks = NULL;
+	timeline->nextDue = 0;
+}
+
+/**
+ * @brief							Initializes a track that writes text one character per step, and ends once every character was written
+ *
+ * @param		track				Pointer to the track (must remain valid while it runs)
+ * @param		row					Row of the text (0 or 1)
+ * @param		col					Column of the first character
+ * @param		text				Pointer to the text (must remain valid while the track runs)
+ * @param		len					Number of characters (a track of 0 characters is never started)
+ * @param		period				Number of ticks between characters
+ */
+void LCD_initRevealTrack(HD44780_LCD_Track_t *track, uint8_t row, uint8_t col, const uint8_t *text, uint8_t len, uint32_t period) {
+	LCD_initTrack(track, trackReveal, len, period);
+
+	track->data = text;
+	track->row = row;
+	track->col = col;
+	track->len = len;
+}
+
+/**
+ * @brief							Initializes a track that shifts the display by one position per step, which costs a single instruction
+ *
+ * @param		track				Pointer to the track (must remain valid while it runs)
+ * @param		right				Whether the display is shifted right (1) or left (0)
+ * @param		steps				Number of positions to shift the display by (0 to scroll forever)
+ * @param		period				Number of ticks between shifts
+ */
+void LCD_initScrollTrack(HD44780_LCD_Track_t *track, uint8_t right, uint16_t steps, uint32_t period) {
+	LCD_initTrack(track, trackScroll, steps, period);
+
+	track->arg = right;
+}
+
+/**
+ * @brief							Initializes a track that loads the next of a sequence of glyphs into a location of the CGRAM each step, changing every cell that shows it at once
+ *
+ * Each step sends only the rows that differ from the glyph the location holds, and then returns the address counter to where it was in the DDRAM
+ *
+ * @param		track				Pointer to the track (must remain valid while it runs)
+ * @param		loc					Location of the glyph (0 to 7)
+ * @param		frames				Pointer to the glyphs, which are loaded in order and then repeated (must remain valid while the track runs)
+ * @param		count				Number of glyphs (a track of 0 glyphs is never started)
+ * @param		period				Number of ticks between glyphs
+ */
+void LCD_initGlyphTrack(HD44780_LCD_Track_t *track, uint8_t loc, const uint8_t (*frames)[8], uint8_t count, uint32_t period) {
+	LCD_initTrack(track, trackGlyph, 0, period);
+
+	track->data = frames[0];
+	track->arg = loc;
+	track->len = count;
+}
+
+/**
+ * @brief							Initializes a track that alternately hides and shows text, starting by hiding it
+ *
+ * @param		track				Pointer to the track (must remain valid while it runs)
+ * @param		row					Row of the text (0 or 1)
+ * @param		col					Column of the first character
+ * @param		text				Pointer to the text (must remain valid while the track runs)
+ * @param		len					Number of characters
+ * @param		period				Number of ticks the text stays hidden or shown for
+ */
+void LCD_initBlinkTrack(HD44780_LCD_Track_t *track, uint8_t row, uint8_t col, const uint8_t *text, uint8_t len, uint32_t period) {
+	LCD_initTrack(track, trackBlink, 0, period);
+
+	track->data = text;
+	track->row = row;
+	track->col = col;
+	track->len = len;
+}
+
+/**
+ * @brief							Starts a track on a timeline from its first step, which is taken by the next call to LCD_tick (a running track is restarted)
+ *
+ * A reveal track without characters or a glyph track without glyphs is not started, as it has nothing to animate
+ *
+ * @param		timeline			Pointer to the timeline
+ * @param		track				Pointer to the track
+ * @param		now					Current tick (in the unit of the periods, e.g. HAL_GetTick)
+ */
+void LCD_startTrack(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_Track_t *track, uint32_t now) {
+	if (track->running) {
+		LCD_stopTrack(timeline, track);
+	}
+	if (LCD_isEmptyTrack(track)) {
+		return;
+	}
+
+	track->step = 0;
+	track->due = now;
+	track->running = 1;
+
+	if (timeline->tracks == NULL || !TICK_REACHED(track->due, timeline->nextDue)) {
+		timeline->nextDue = track->due;
+	}
+
+	track->next = timeline->tracks;
+	timeline->tracks = track;
+}
+
+/**
+ * @brief							Stops a track, leaving the LCD as its last step did
+ *
+ * @param		timeline			Pointer to the timeline
+ * @param		track				Pointer to the track
+ */
+void LCD_stopTrack(HD44780_LCD_Timeline_t *timeline, HD44780_LCD_Track_t *track) {
+	HD44780_LCD_Track_t **link = &(timeline->tracks);
+
+	while (*link != NULL && *link != track) {
+		link = &((*link)->next);
+	}
+	if (*link != NULL) {
+		*link = track->next;
+	}
+
+	track->next = NULL;
+	track->running = 0;
+}
+
+/**
+ * @brief							Steps the tracks of a timeline that are due, and must be called periodically (e.g. from the main loop)
+ *
+ * Until the earliest track is due, the call only compares the tick, so idle time between steps costs next to nothing however many tracks run. A
+ * track that fell behind by more than its period skips the steps it missed instead of taking them all at once
+ *
+ * @param		timeline			Pointer to the timeline
+ * @param		now					Current tick (in the unit of the periods, e.g. HAL_GetTick)
+ *
+ * @return							Number of steps that were taken
+ */
+uint32_t LCD_tick(HD44780_LCD_Timeline_t *timeline, uint32_t now) {
+	HD44780_LCD_Track_t **link = &(timeline->tracks);
+	uint32_t nextDue = now + 0x7FFFFFFFU;
+	uint32_t taken = 0;
+
+	if (timeline->tracks == NULL || !TICK_REACHED(now, timeline->nextDue)) {
+		return 0;
+	}
+
+	while (*link != NULL) {
+		HD44780_LCD_Track_t *track = *link;
+
+		if (TICK_REACHED(now, track->due)) {
+			LCD_stepTrack(timeline->lcd, track);
+			++taken;
+
+			// a track that has taken all its steps leaves the timeline
+			if (++track->step == track->steps && track->steps != 0) {
+				*link = track->next;
+				track->next = NULL;
+				track->running = 0;
+				continue;
+			}
+			// the glyphs of a glyph track repeat, so its step wraps around with them
+			if (track->kind == trackGlyph && track->step == track->len) {
+				track->step = 0;
+			}
+
+			track->due += track->period;
+			if (TICK_REACHED(now, track->due)) {
+				track->due = now + track->period;
+			}
+		}
+
+		if (!TICK_REACHED(track->due, nextDue)) {
+			nextDue = track->due;
+		}
+		link = &(track->next);
+	}
+
+	timeline->nextDue = nextDue;
+	return taken;
+}
@@ -0,0 +1,256 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_UTF8.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the UTF-8 text path, which decodes text into the codes of the character ROM of the LCD and draws the missing characters into the CGRAM
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+#include "HD44780_ROM.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// the number of characters encoded before they are sent to the LCD together (this sizes a buffer on the stack)
+#define   TEXT_CHUNK			16
+// the code point that malformed UTF-8 is decoded as
+#define   REPLACEMENT_CHAR		0xFFFD
+
+// the number of continuation bytes that follow a byte of UTF-8, by its 4 most significant bits (0xFF for continuation bytes)
+static const uint8_t LCD_utf8Follow[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF, 1, 1, 2, 3 };
+// the bits of the code point held by the first byte of a sequence, by the number of continuation bytes that follow it
+static const uint8_t LCD_utf8LeadMask[4] = { 0x7F, 0x1F, 0x0F, 0x07 };
+// the smallest code point of a sequence, by the number of continuation bytes (smaller ones are overlong encodings)
+static const uint32_t LCD_utf8Min[4] = { 0x00, 0x80, 0x800, 0x10000 };
+
+/** Private Functions --------------------------------------------------------*/
+
+/**
+ * @brief							Returns the code a character is shown with, from the ROM or a location of the CGRAM that the text holds
+ *
+ * @param		text				Pointer to the text
+ * @param		codePoint			Code point of the character
+ * @param		code				Code of the character, written unless a transfer fails
+ *
+ * @return							Status of the transfers to the LCD
+ */
+static HAL_StatusTypeDef LCD_textCode(HD44780_LCD_Text_t *text, uint32_t codePoint, uint8_t *code) {
+	uint8_t glyph[8];
+	uint8_t loc;
+	HAL_StatusTypeDef status;
+
+	*code = LCD_romCode(text->rom, codePoint);
+	if (*code != 0) {
+		return HAL_OK;
+	}
+
+	*code = LCD_UTF8_MISSING;
+	if (text->cache == NULL || !LCD_fontCodePointGlyph(codePoint, glyph)) {
+		return HAL_OK;
+	}
+
+	status = LCD_acquireGlyph(text->cache, glyph, &loc);
+	if (status == HAL_BUSY) {
+		return HAL_OK;
+	}
+
+	// the text holds each location once, however many of its characters show it
+	if (text->held & (1U << loc)) {
+		LCD_releaseGlyph(text->cache, loc);
+	}
+	text->held |= 1U << loc;
+	*code = loc;
+
+	return status;
+}
+
+/** Functions ----------------------------------------------------------------*/
+
+/**
+ * @brief							Returns the code of a character in a character ROM, in constant time
+ *
+ * Control characters U+0001 to U+000F are kept as codes of the CGRAM (whose 8 locations repeat, so U+0008 shows location 0)
+ *
+ * @param		rom					Character ROM of the LCD (one of HD44780_LCD_ROM)
+ * @param		codePoint			Unicode code point of the character
+ *
+ * @return							Code of the character, 0 if the ROM does not have it
+ */
+uint8_t LCD_romCode(enum HD44780_LCD_ROM rom, uint32_t codePoint) {
+	const uint8_t *page = (codePoint < 0x400) ? (LCD_romPages[rom][codePoint >> 7]) : (NULL);
+
+	if (codePoint - 0x01 <= 0x0F - 0x01) {
+		return (uint8_t) codePoint;
+	}
+	if (page != NULL) {
+		return page[codePoint & 0x7F];
+	}
+
+	// the halfwidth katakana (U+FF61 to U+FF9F) are in the same order as in the A00 ROM
+	if (rom == romA00 && codePoint - 0xFF61 <= 0xFF9F - 0xFF61) {
+		return (uint8_t) (codePoint - 0xFF61 + 0xA1);
+	}
+
+	for (uint32_t i = 0; i < sizeof(LCD_romSymbols[0]) / sizeof(LCD_romSymbols[0][0]); ++i) {
+		if (LCD_romSymbols[rom][i].codePoint == codePoint) {
+			return LCD_romSymbols[rom][i].code;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief							Initializes the state of UTF-8 text written to an LCD, which decodes text split at any byte across calls
+ *
+ * @param		text				Pointer to the text
+ * @param		lcd					Pointer to LCD structure
+ * @param		rom					Character ROM of the LCD (the part number of the controller ends with it, e.g. A00 for HD44780UA00)
+ * @param		cache				Pointer to the glyph cache that characters missing from the ROM are drawn into (NULL to show them as LCD_UTF8_MISSING)
+ */
+void LCD_initText(HD44780_LCD_Text_t *text, HD44780_LCD_t *lcd, enum HD44780_LCD_ROM rom, HD44780_LCD_GlyphCache_t *cache) {
+	text->lcd = lcd;
+	text->cache = cache;
+	text->codePoint = 0;
+	text->rom = rom;
+	text->pending = 0;
+	text->length = 0;
+	text->held = 0;
+}
+
+/**
+ * @brief							Decodes the next byte of UTF-8 text
+ *
+ * Malformed sequences (stray continuation bytes, overlong encodings, surrogates and invalid bytes) are decoded as U+FFFD, and a sequence cut short
+ * by the start of the next one is dropped
+ *
+ * @param		text				Pointer to the text
+ * @param		byte				Next byte of the text
+ * @param		codePoint			Code point of the character, written when the byte completes one
+ *
+ * @return							1 if the byte completed a character, 0 otherwise
+ */
+uint8_t LCD_decodeUTF8(HD44780_LCD_Text_t *text, uint8_t byte, uint32_t *codePoint) {
+	const uint8_t follow = LCD_utf8Follow[byte >> 4];
+
+	if (follow != 0xFF) {
+		text->codePoint = byte & LCD_utf8LeadMask[follow];
+		text->pending = follow;
+		text->length = follow;
+
+		// bytes 0xF8 to 0xFF never start a sequence
+		if (follow == 3 && byte > 0xF4) {
+			text->pending = 0;
+			*codePoint = REPLACEMENT_CHAR;
+			return 1;
+		}
+		if (follow != 0) {
+			return 0;
+		}
+	} else {
+		if (text->pending == 0) {
+			*codePoint = REPLACEMENT_CHAR;
+			return 1;
+		}
+
+		text->codePoint = (text->codePoint << 6) | (byte & 0x3F);
+		if (--text->pending != 0) {
+			return 0;
+		}
+	}
+
+	*codePoint = text->codePoint;
+	if (*codePoint < LCD_utf8Min[text->length] || *codePoint > 0x10FFFF || (*codePoint >= 0xD800 && *codePoint <= 0xDFFF)) {
+		*codePoint = REPLACEMENT_CHAR;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief							Writes UTF-8 text starting at the position of the cursor, in the codes of the ROM of the LCD
+ *
+ * Characters the ROM does not have are drawn from the built-in font into locations acquired from the glyph cache of the text, which the text holds
+ * until LCD_releaseText. Characters the font does not have either, or that do not fit in the cache, are shown as LCD_UTF8_MISSING. The address
+ * counter is returned to the DDRAM after glyphs are loaded, so the text continues from the cursor
+ *
+ * @param		text				Pointer to the text
+ * @param		buf					Pointer to the UTF-8 text (a character may be split across calls)
+ * @param		len					Number of bytes
+ *
+ * @return							Status of the transfers to the LCD (the write stops at the first transfer that fails)
+ */
+HAL_StatusTypeDef LCD_sendUTF8(HD44780_LCD_Text_t *text, const char *buf, uint32_t len) {
+	HD44780_LCD_t *lcd = text->lcd;
+	uint8_t codes[TEXT_CHUNK];
+	HAL_StatusTypeDef status = HAL_OK;
+	uint32_t i = 0;
+
+	while (i < len && status == HAL_OK) {
+		const uint8_t inCGRAM = lcd->shadow.inCGRAM;
+		const uint8_t addr = lcd->shadow.addr;
+		uint32_t count = 0;
+
+		for (; i < len && count < TEXT_CHUNK && status == HAL_OK; ++i) {
+			uint32_t codePoint;
+
+			if (LCD_decodeUTF8(text, (uint8_t) buf[i], &codePoint)) {
+				status = LCD_textCode(text, codePoint, &codes[count++]);
+			}
+		}
+
+		if (status == HAL_OK && !inCGRAM && lcd->shadow.inCGRAM) {
+			status = LCD_sendInstruction(lcd, LCD_SET_DDRAMADDR | addr);
+		}
+		if (status == HAL_OK && count != 0) {
+			status = LCD_sendBuffer(lcd, codes, count);
+		}
+	}
+
+	return status;
+}
+
+/**
+ * @brief							Formats text as printf does and writes it as UTF-8 starting at the position of the cursor
+ *
+ * @param		text				Pointer to the text
+ * @param		format				Format of the text, followed by its arguments (the formatted text is cut to LCD_PRINTF_SIZE - 1 bytes)
+ *
+ * @return							Status of the transfers to the LCD, HAL_ERROR if the text could not be formatted
+ */
+HAL_StatusTypeDef LCD_printf(HD44780_LCD_Text_t *text, const char *format, ...) {
+	char buf[LCD_PRINTF_SIZE];
+	va_list args;
+	int len;
+
+	va_start(args, format);
+	len = vsnprintf(buf, sizeof(buf), format, args);
+	va_end(args);
+
+	if (len < 0) {
+		return HAL_ERROR;
+	}
+	if ((uint32_t) len >= sizeof(buf)) {
+		len = sizeof(buf) - 1;
+	}
+
+	return LCD_sendUTF8(text, buf, len);
+}
+
+/**
+ * @brief							Releases the locations of the CGRAM that a text holds back to its glyph cache (the cells showing them should be overwritten first)
+ *
+ * @param		text				Pointer to the text
+ */
+void LCD_releaseText(HD44780_LCD_Text_t *text) {
+	for (uint32_t loc = 0; loc < LCD_CGRAM_GLYPHS; ++loc) {
+		if (text->held & (1U << loc)) {
+			LCD_releaseGlyph(text->cache, loc);
+		}
+	}
+	text->held = 0;
+}
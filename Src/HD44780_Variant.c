@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * @file     HD44780_Variant.c
+ * @author   Aditya Agarwal (aditya.agarwal@dumblebots.com)
+ * @version  V1.0
+ * @brief    Contains the timing profiles, initialization sequences and extended commands of the HD44780 Controller and its compatible variants
+ ******************************************************************************
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32g0xx_hal.h"
+#include "HD44780_LCD.h"
+
+// function set of the US2066 that selects the extended instruction set (RE = 1, 2 lines)
+#define   US2066_FUNCTION_RE	(LCD_SEQ_FUNCTION | LCD_SET_FUNCTION | LCD_LINE_COUNT_2 | 0x02)
+// instruction of the US2066 that enables the OLED command set (SD = 1, only valid while RE = 1)
+#define   US2066_OLED_ENABLE	0x79
+// instruction of the US2066 that disables the OLED command set (SD = 0)
+#define   US2066_OLED_DISABLE	0x78
+
+/** Sequences ----------------------------------------------------------------*/
+
+// setup of the US2066 for a 2-line panel with a 3.3V supply (internal regulator off, default clock, SEG/COM directions, ROM A)
+static const uint16_t us2066Setup[] = {
+	US2066_FUNCTION_RE, 0x71, LCD_SEQ_DATA | 0x00,
+	US2066_OLED_ENABLE, 0xD5, 0x70, US2066_OLED_DISABLE,
+	0x08, 0x06, 0x72, LCD_SEQ_DATA | 0x00,
+	US2066_OLED_ENABLE, 0xDA, 0x10, 0xDC, 0x00, 0xD9, 0xF1, 0xDB, 0x40, US2066_OLED_DISABLE
+};
+
+// contrast of the US2066 (the contrast replaces the entry after 0x81)
+static const uint16_t us2066Contrast[] = {
+	US2066_FUNCTION_RE, US2066_OLED_ENABLE, 0x81, 0x00, US2066_OLED_DISABLE
+};
+
+// setup of the WS0010 (display off, then character mode with the internal power turned on)
+static const uint16_t ws0010Setup[] = {
+	LCD_CONTROL_DISPLAY, 0x17
+};
+
+/** Variants -----------------------------------------------------------------*/
+
+// Hitachi HD44780 (execution times at 270kHz)
+const HD44780_LCD_Variant_t LCD_VARIANT_HD44780 = {
+	.powerUpMs = 50,
+	.wakeUs = 4100,
+	.clearUs = 1520,
+	.execUs = 37
+};
+
+// Samsung KS0066
+const HD44780_LCD_Variant_t LCD_VARIANT_KS0066 = {
+	.powerUpMs = 30,
+	.wakeUs = 4100,
+	.clearUs = 1530,
+	.execUs = 39
+};
+
+// Sitronix ST7066U
+const HD44780_LCD_Variant_t LCD_VARIANT_ST7066U = {
+	.powerUpMs = 40,
+	.wakeUs = 4100,
+	.clearUs = 1520,
+	.execUs = 37
+};
+
+// Sunplus SPLC780D
+const HD44780_LCD_Variant_t LCD_VARIANT_SPLC780D = {
+	.powerUpMs = 40,
+	.wakeUs = 4100,
+	.clearUs = 1520,
+	.execUs = 37
+};
+
+// Sitronix ST7032/ST7036 (its contrast, booster and icons are set through the extended instruction table by the ST7032 transports)
+const HD44780_LCD_Variant_t LCD_VARIANT_ST7032 = {
+	.powerUpMs = 40,
+	.wakeUs = 27,
+	.clearUs = 1080,
+	.execUs = LCD_EXT_EXEC_US
+};
+
+// Solomon Systech US2066 character OLED controller, with a contrast (brightness) setting and double-height characters
+const HD44780_LCD_Variant_t LCD_VARIANT_US2066 = {
+	.powerUpMs = 20,
+	.wakeUs = 100,
+	.clearUs = 2000,
+	.execUs = 1,
+	.doubleHeight = 0x04,
+	.setupLen = sizeof(us2066Setup) / sizeof(us2066Setup[0]),
+	.contrastLen = sizeof(us2066Contrast) / sizeof(us2066Contrast[0]),
+	.contrastPos = 3,
+	.defaultContrast = 0x7F,
+	.setup = us2066Setup,
+	.contrast = us2066Contrast
+};
+
+// Winstar WS0010 character OLED controller (the internal DC-DC converter needs a long time to start)
+const HD44780_LCD_Variant_t LCD_VARIANT_WS0010 = {
+	.powerUpMs = 500,
+	.wakeUs = 100,
+	.clearUs = 6200,
+	.execUs = 1,
+	.setupLen = sizeof(ws0010Setup) / sizeof(ws0010Setup[0]),
+	.setup = ws0010Setup
+};